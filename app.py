@@ -4,6 +4,7 @@ import os
 import time
 import csv
 import io
+import zipfile
 from werkzeug.utils import secure_filename
 
 app = Flask(__name__)
@@ -40,11 +41,18 @@ def read_inventory():
                 })
     return meds
 
+def replace_file(path, text):
+    """Write to a temp file and rename it over path. prog2 may have the old
+    inventory.txt memory-mapped; truncating it in place would crash that reader."""
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        f.write(text)
+    os.replace(tmp, path)
+
 def write_inventory(meds):
     valid = [m for m in meds if all(k in m for k in ("name", "batch", "expiry", "qty", "price", "orig"))]
-    with open("inventory.txt", "w") as f:
-        for m in valid:
-            f.write(f"{m['name']},{m['batch']},{m['expiry']},{m['qty']},{m['price']},{m['orig']}\n")
+    replace_file("inventory.txt", "".join(
+        f"{m['name']},{m['batch']},{m['expiry']},{m['qty']},{m['price']},{m['orig']}\n" for m in valid))
 
 def load_inventory():
     if not os.path.exists('inventory.txt'):
@@ -67,9 +75,8 @@ def load_inventory():
     return medicines
 
 def save_inventory(medicines):
-    with open('inventory.txt', 'w') as file:
-        for med in medicines:
-            file.write(f"{med['name']},{med['batch']},{med['expiry']},{med['quantity']},{med['price']},{med['orig']}\n")
+    replace_file('inventory.txt', "".join(
+        f"{med['name']},{med['batch']},{med['expiry']},{med['quantity']},{med['price']},{med['orig']}\n" for med in medicines))
 
 def load_history():
     if not os.path.exists('history.txt'):
@@ -91,6 +98,18 @@ def load_history():
             })
     return history_records
 
+def archived_history():
+    """Sealed history segments written by prog2 (history_archive/*.mhz), plus a
+    history.txt.sealing left by an interrupted seal. load_history() cannot read
+    the compressed segments; prog2's Show/Search History can."""
+    paths = []
+    if os.path.isdir('history_archive'):
+        paths = sorted(os.path.join('history_archive', n)
+                       for n in os.listdir('history_archive') if n.endswith('.mhz'))
+    if os.path.exists('history.txt.sealing'):
+        paths.append('history.txt.sealing')
+    return paths
+
 def log(msg):
     with open("history.txt","a") as f:
         f.write(f"{now()} {msg}\n")
@@ -214,7 +233,7 @@ def restock():
 @app.route("/history")
 def history():
     history_records = load_history()
-    return render_template('history.html', history=history_records)
+    return render_template('history.html', history=history_records, archived=len(archived_history()))
 
 @app.route("/api/medicines")
 def api_medicines():
@@ -380,13 +399,29 @@ def restore():
 
 @app.route("/backup_history")
 def backup_history():
-    """Download transaction history as text file"""
+    """Download transaction history as a text file, or as a zip of the live log
+    and prog2's archived segments once history.txt has been rotated"""
     try:
-        if not os.path.exists('history.txt'):
+        archived = archived_history()
+        if not os.path.exists('history.txt') and not archived:
             flash('No history file found!', 'warning')
             return redirect(url_for('history'))
         
         log("Transaction history backup downloaded")
+        if archived:
+            # Segments are already compressed; store them as they are.
+            buf = io.BytesIO()
+            with zipfile.ZipFile(buf, 'w', zipfile.ZIP_DEFLATED) as zf:
+                for path in archived:
+                    zf.write(path, path, compress_type=zipfile.ZIP_STORED)
+                zf.write('history.txt', 'history.txt')
+            buf.seek(0)
+            return send_file(
+                buf,
+                as_attachment=True,
+                download_name=f'history_backup_{time.strftime("%Y%m%d_%H%M%S")}.zip',
+                mimetype='application/zip'
+            )
         return send_file(
             'history.txt',
             as_attachment=True,
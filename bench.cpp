@@ -0,0 +1,892 @@
+// Benchmark suite for InventoryManager with a deterministic workload generator.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench.cpp -o bench
+// Run:   ./bench [--n 1000,10000] [--ops 5000] [--reps 3] [--seed 42] [--out results.jsonl]
+//                [--history 200000] [--manifest 100000] [--bill 1000000] [--metrics metrics.prom]
+//        ./bench --gen-inventory N FILE    (write a synthetic inventory.txt and exit)
+//
+// Every result is printed as one JSON object per line so runs from different
+// versions can be diffed or loaded into a spreadsheet. All file I/O happens in
+// a scratch directory under the system temp dir, never in the working tree.
+#define MEDINV_NO_MAIN
+#include "prog2.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace fs = std::filesystem;
+
+static const int BENCH_SCHEMA_VERSION = 1;
+
+// ===============================
+// Deterministic Generator
+// ===============================
+// SplitMix64: tiny, fast and identical on every platform, unlike std::mt19937
+// paired with the implementation-defined std:: distributions.
+class Rng
+{
+private:
+    uint64_t state;
+
+public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [lo, hi].
+    int64_t range(int64_t lo, int64_t hi) { return lo + (int64_t)(next() % (uint64_t)(hi - lo + 1)); }
+
+    // Uniform double in [0, 1).
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Samples ranks 0..n-1 with P(k) proportional to 1 / (k + 1)^s.
+class Zipf
+{
+private:
+    std::vector<double> cdf;
+
+public:
+    Zipf(size_t n, double s)
+    {
+        cdf.resize(n);
+        double sum = 0.0;
+        for (size_t k = 0; k < n; k++)
+        {
+            sum += 1.0 / std::pow((double)(k + 1), s);
+            cdf[k] = sum;
+        }
+        for (double &c : cdf)
+            c /= sum;
+    }
+
+    size_t sample(Rng &rng) const
+    {
+        size_t k = std::lower_bound(cdf.begin(), cdf.end(), rng.unit()) - cdf.begin();
+        return std::min(k, cdf.size() - 1);
+    }
+};
+
+struct InventorySpec
+{
+    size_t batches = 10000;
+    double nameSkew = 1.1;        // Zipf exponent over the medicine name pool
+    double expiredFraction = 0.1; // batches dated in the past
+    double lowStockFraction = 0.05;
+    int maxPastDays = 365;
+    int maxFutureDays = 3 * 365;
+};
+
+struct WorkloadSpec
+{
+    size_t ops = 5000;
+    double saleSkew = 0.99; // Zipf exponent over batch popularity
+    double restockFraction = 0.05;
+    double sweepFraction = 0.001;
+};
+
+enum class OpKind
+{
+    Sale,
+    Restock,
+    ExpirySweep
+};
+
+struct Op
+{
+    OpKind kind;
+    std::string batch;
+    int qty;
+};
+
+static const char *NAME_POOL[] = {
+    "Paracetamol", "Dolo", "Crocin", "Combiflam", "Cofcil", "Amoxicillin", "Alegra",
+    "Vicks Cough Drop", "Azithromycin", "Cetirizine", "Ibuprofen", "Pantoprazole",
+    "Omeprazole", "Metformin", "Amlodipine", "Atorvastatin", "Losartan", "Montelukast",
+    "Ranitidine", "Domperidone", "Ondansetron", "Levocetirizine", "Ciprofloxacin",
+    "Doxycycline", "Ofloxacin", "Diclofenac", "Aceclofenac", "Vitamin C", "Zinc",
+    "Calcium D3", "ORS", "Digene", "Benadryl", "Ascoril", "Saridon", "Disprin",
+    "Betadine", "Volini", "Moov", "Electral"};
+
+static std::string dateFromToday(int days)
+{
+    std::time_t t = std::time(nullptr) + (std::time_t)days * 86400;
+    std::tm *tm = std::localtime(&t);
+    char buf[16];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", tm);
+    return buf;
+}
+
+// Batch numbers are dense ("B0000001"...) but the rows are shuffled so that
+// file order, popularity rank and batch number are uncorrelated.
+static std::string batchName(size_t i)
+{
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "B%07zu", i);
+    return buf;
+}
+
+static std::vector<Medicine> generateInventory(const InventorySpec &spec, uint64_t seed)
+{
+    Rng rng(seed);
+    const size_t poolSize = sizeof(NAME_POOL) / sizeof(NAME_POOL[0]);
+    Zipf names(poolSize, spec.nameSkew);
+
+    std::vector<Medicine> meds;
+    meds.reserve(spec.batches);
+    for (size_t i = 0; i < spec.batches; i++)
+    {
+        std::string name = NAME_POOL[names.sample(rng)];
+        int days = rng.unit() < spec.expiredFraction ? -(int)rng.range(1, spec.maxPastDays)
+                                                     : (int)rng.range(1, spec.maxFutureDays);
+        int qty = rng.unit() < spec.lowStockFraction ? (int)rng.range(0, 9)
+                                                     : (int)rng.range(10, 100000);
+        money::Paise price = (money::Paise)rng.range(1, 1000) * 50;
+        meds.push_back(Medicine(name, batchName(i), dateFromToday(days), qty, price));
+    }
+    for (size_t i = meds.size(); i > 1; i--)
+        std::swap(meds[i - 1], meds[rng.next() % i]);
+    return meds;
+}
+
+static std::vector<Op> generateWorkload(const WorkloadSpec &spec, size_t batches, uint64_t seed)
+{
+    Rng rng(seed ^ 0xA5A5A5A5A5A5A5A5ULL);
+    Zipf popularity(batches, spec.saleSkew);
+
+    // Popularity rank -> batch number, so the hottest batches are scattered.
+    std::vector<size_t> rankToBatch(batches);
+    for (size_t i = 0; i < batches; i++)
+        rankToBatch[i] = i;
+    for (size_t i = batches; i > 1; i--)
+        std::swap(rankToBatch[i - 1], rankToBatch[rng.next() % i]);
+
+    std::vector<Op> ops;
+    ops.reserve(spec.ops);
+    for (size_t i = 0; i < spec.ops; i++)
+    {
+        double r = rng.unit();
+        std::string batch = batchName(rankToBatch[popularity.sample(rng)]);
+        if (r < spec.sweepFraction)
+            ops.push_back({OpKind::ExpirySweep, "", 0});
+        else if (r < spec.sweepFraction + spec.restockFraction)
+            ops.push_back({OpKind::Restock, batch, (int)rng.range(100, 10000)});
+        else
+            ops.push_back({OpKind::Sale, batch, (int)rng.range(1, 5)});
+    }
+    return ops;
+}
+
+static void writeInventory(const std::vector<Medicine> &meds, const std::string &filename)
+{
+    std::ofstream out(filename);
+    for (const Medicine &med : meds)
+        med.saveToFile(out);
+}
+
+// Supplier manifest in inventory.txt layout: most rows restock one of the
+// `batches` stocked batches (uniformly, with repeats), the rest introduce new
+// batch numbers, some of which recur later in the same manifest.
+static void writeManifest(size_t lines, size_t batches, double newFraction, const std::string &filename,
+                          uint64_t seed)
+{
+    Rng rng(seed ^ 0x3C3C3C3C3C3C3C3CULL);
+    const size_t poolSize = sizeof(NAME_POOL) / sizeof(NAME_POOL[0]);
+    size_t newBatches = std::max<size_t>((size_t)(lines * newFraction * 0.8), 1);
+    std::string buffer;
+    for (size_t i = 0; i < lines; i++)
+    {
+        size_t b = rng.unit() < newFraction ? batches + rng.next() % newBatches : rng.next() % batches;
+        Medicine row(NAME_POOL[b % poolSize], batchName(b), dateFromToday((int)rng.range(180, 3 * 365)),
+                     (int)rng.range(50, 5000), (money::Paise)(b * 7919 % 1000 + 1) * 50);
+        row.appendTo(buffer);
+    }
+    std::ofstream out(filename, std::ios::binary);
+    out.write(buffer.data(), (std::streamsize)buffer.size());
+}
+
+// The stringstream loader and ostream writer Medicine used before
+// MedicineSchema, kept as the baseline for the codec benchmarks.
+static Medicine parseLineStringstream(const std::string &line)
+{
+    std::stringstream ss(line);
+    std::string n, b, e, qStr, pStr, oqStr;
+    getline(ss, n, ',');
+    getline(ss, b, ',');
+    getline(ss, e, ',');
+    getline(ss, qStr, ',');
+    getline(ss, pStr, ',');
+    getline(ss, oqStr, ',');
+    int q = qStr.empty() ? 0 : std::stoi(qStr);
+    money::Paise p = pStr.empty() ? 0 : std::llround(std::stof(pStr) * 100.0);
+    int oq = oqStr.empty() ? q : std::stoi(oqStr);
+    Medicine med(n, b, e, oq, p);
+    med.setQuantity(q);
+    return med;
+}
+
+static void formatLineOstream(std::ostream &out, const Medicine &med)
+{
+    out << med.getName() << "," << med.getBatchNumber() << "," << med.getExpiryDate() << ","
+        << med.getQuantity() << "," << med.getPrice() / 100.0f << "," << med.getOriginalQuantity() << "\n";
+}
+
+static bool sameRecord(const Medicine &a, const Medicine &b)
+{
+    return a.getName() == b.getName() && a.getBatchNumber() == b.getBatchNumber() &&
+           a.getExpiryDate() == b.getExpiryDate() && a.getQuantity() == b.getQuantity() &&
+           a.getPrice() == b.getPrice() && a.getOriginalQuantity() == b.getOriginalQuantity();
+}
+
+// Round-trip check for the backup CSV: awkward names through the codec, then a
+// generated inventory through saveBackupCsv()/loadBackupCsv(). Returns the
+// number of failures. Runs in the scratch directory.
+static size_t checkBackupCsv(uint64_t seed)
+{
+    size_t failures = 0;
+    std::vector<Medicine> tricky = {
+        Medicine("Cough Syrup, 100ml", "B1", "2027-01-31", 5, 12050),
+        Medicine("\"Extra\" Strength", "B\"2", "2026-02-28", 0, 99),
+        Medicine(" Leading space", ",B3,", "2025-12-01", 1500000, 850),
+        Medicine("", "B4", "", 7, 0)};
+    for (const Medicine &med : tricky)
+    {
+        std::string line;
+        MedicineSchema<Medicine>::BackupCsv::write(line, med);
+        Medicine back;
+        MedicineSchema<Medicine>::BackupCsv::parse(line.data(), line.data() + line.size(), back);
+        if (!sameRecord(med, back) && failures++ < 10)
+            std::cerr << "backup csv check failed: " << line << "\n";
+    }
+
+    InventorySpec spec;
+    spec.batches = 2000;
+    std::vector<Medicine> meds = generateInventory(spec, seed);
+    writeInventory(meds, "backup_source.txt");
+    InventoryManager source, restored;
+    source.loadFromFile("backup_source.txt");
+    if (!source.saveBackupCsv("backup.csv") || !restored.loadBackupCsv("backup.csv") || restored.size() != meds.size())
+    {
+        std::cerr << "backup csv check failed: could not write and reload backup.csv\n";
+        return failures + 1;
+    }
+    for (const Medicine &med : meds)
+    {
+        Medicine *back = restored.findBatch(med.getBatchNumber());
+        if ((!back || !sameRecord(med, *back)) && failures++ < 10)
+            std::cerr << "backup csv check failed: batch " << med.getBatchNumber() << "\n";
+    }
+    return failures;
+}
+
+// ===============================
+// Harness
+// ===============================
+// Swallows the reports' console output so the benchmarks time the scan and
+// formatting rather than the terminal.
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+class CoutSilencer
+{
+private:
+    NullBuffer sink;
+    std::streambuf *saved;
+
+public:
+    CoutSilencer() : saved(std::cout.rdbuf(&sink)) {}
+    ~CoutSilencer() { std::cout.rdbuf(saved); }
+};
+
+struct BenchResult
+{
+    std::string name;
+    size_t n;
+    size_t ops;
+    double minNsPerOp;
+    double medianNsPerOp;
+};
+
+class BenchRunner
+{
+private:
+    std::vector<BenchResult> results;
+    std::ofstream jsonOut;
+    int reps;
+
+public:
+    BenchRunner(int r, const std::string &outFile) : reps(r)
+    {
+        if (!outFile.empty())
+            jsonOut.open(outFile, std::ios::app);
+    }
+
+    // setup runs untimed before every repetition; body performs `ops` operations.
+    void run(const std::string &name, size_t n, size_t ops,
+             const std::function<void()> &setup, const std::function<void()> &body)
+    {
+        std::vector<double> samples;
+        for (int r = 0; r < reps; r++)
+        {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto stop = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            samples.push_back(ns / (double)std::max<size_t>(ops, 1));
+        }
+        std::sort(samples.begin(), samples.end());
+        BenchResult res{name, n, ops, samples.front(), samples[samples.size() / 2]};
+        results.push_back(res);
+        report(res);
+    }
+
+    void report(const BenchResult &res)
+    {
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1)
+             << "{\"schema\":" << BENCH_SCHEMA_VERSION
+             << ",\"bench\":\"" << res.name << "\""
+             << ",\"n\":" << res.n
+             << ",\"ops\":" << res.ops
+             << ",\"reps\":" << reps
+             << ",\"min_ns_per_op\":" << res.minNsPerOp
+             << ",\"median_ns_per_op\":" << res.medianNsPerOp
+             << ",\"ops_per_sec\":" << (res.minNsPerOp > 0 ? 1e9 / res.minNsPerOp : 0.0)
+             << "}";
+        emit(line.str());
+    }
+
+    // One-off measurements that are not timings (sizes, ratios).
+    void value(const std::string &name, size_t n, const std::string &key, double v)
+    {
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "{\"schema\":" << BENCH_SCHEMA_VERSION
+             << ",\"bench\":\"" << name << "\""
+             << ",\"n\":" << n
+             << ",\"" << key << "\":" << v << "}";
+        emit(line.str());
+    }
+
+    void emit(const std::string &line)
+    {
+        std::cout << line << "\n";
+        if (jsonOut)
+            jsonOut << line << "\n";
+    }
+};
+
+// ===============================
+// Benchmarks
+// ===============================
+static void runSuite(BenchRunner &runner, size_t n, const WorkloadSpec &wspec, uint64_t seed)
+{
+    InventorySpec ispec;
+    ispec.batches = n;
+    std::vector<Medicine> meds = generateInventory(ispec, seed);
+    std::vector<Op> ops = generateWorkload(wspec, n, seed);
+    writeInventory(meds, "snapshot.txt");
+
+    std::vector<std::string> keys;
+    for (const Op &op : ops)
+        if (op.kind == OpKind::Sale)
+            keys.push_back(op.batch);
+
+    InventoryManager manager;
+    auto reload = [&]() { manager.loadFromFile("snapshot.txt"); };
+    auto freshHistory = [&]()
+    {
+        reload();
+        std::remove("history.txt");
+        fs::remove_all("history_archive");
+    };
+    auto nothing = []() {};
+
+    runner.run("load", n, n, nothing, reload);
+
+    runner.run("save", n, n, reload, [&]() { manager.saveToFile("inventory.txt"); });
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream in("snapshot.txt");
+        std::string line;
+        while (getline(in, line))
+            lines.push_back(line);
+    }
+    std::vector<Medicine> parsed(lines.size());
+    runner.run("parse_stringstream", n, lines.size(), nothing, [&]()
+    {
+        for (size_t i = 0; i < lines.size(); i++)
+            parsed[i] = parseLineStringstream(lines[i]);
+    });
+    runner.run("parse_schema", n, lines.size(), nothing, [&]()
+    {
+        for (size_t i = 0; i < lines.size(); i++)
+            parsed[i] = Medicine::parse(lines[i].data(), lines[i].data() + lines[i].size());
+    });
+    runner.run("format_ostream", n, meds.size(), nothing, [&]()
+    {
+        std::ostringstream out;
+        for (const Medicine &med : meds)
+            formatLineOstream(out, med);
+    });
+    runner.run("format_schema", n, meds.size(), nothing, [&]()
+    {
+        std::string out;
+        for (const Medicine &med : meds)
+            med.appendTo(out);
+    });
+    runner.run("save_binary", n, n, reload, [&]() { manager.saveBinary("snapshot.bin"); });
+    runner.run("load_binary", n, n, nothing, [&]() { manager.loadBinary("snapshot.bin"); });
+
+    runner.run("lookup", n, keys.size(), reload, [&]()
+    {
+        size_t hits = 0;
+        for (const std::string &k : keys)
+            hits += manager.findBatch(k) != nullptr;
+        if (hits != keys.size())
+            std::cerr << "lookup: missing batches\n";
+    });
+
+    billing::Bill bill; // one-line scratch bill per sale, as a till would use
+    auto buyAll = [&]()
+    {
+        for (const Op &op : ops)
+        {
+            if (op.kind != OpKind::Sale)
+                continue;
+            Medicine *med = manager.findBatch(op.batch);
+            bill.clear();
+            if (med)
+                manager.sellBatch(*med, op.qty, bill);
+        }
+    };
+    runner.run("buy", n, keys.size(), freshHistory, buyAll);
+
+    // Same loop with instrumentation switched off, to measure its overhead.
+    metrics::setEnabled(false);
+    runner.run("buy_metrics_off", n, keys.size(), freshHistory, buyAll);
+    metrics::setEnabled(true);
+
+    // Restart-to-first-sale: eager parse vs. lazy mapped open. The previous
+    // manager is destroyed in setup so joining its builder is not timed.
+    std::unique_ptr<InventoryManager> restarted;
+    const std::string &firstKey = keys.front();
+    auto firstSale = [&](bool lazyOpen)
+    {
+        restarted.reset(new InventoryManager());
+        if (lazyOpen)
+            restarted->openLazy("snapshot.txt");
+        else
+            restarted->loadFromFile("snapshot.txt");
+        Medicine *med = restarted->findBatch(firstKey);
+        billing::Bill bill;
+        if (!med || !restarted->sellBatch(*med, 1, bill))
+            std::cerr << "first sale failed\n";
+    };
+    auto dropRestarted = [&]() { restarted.reset(); };
+    runner.run("first_sale_eager", n, 1, dropRestarted, [&]() { firstSale(false); });
+    runner.run("first_sale_lazy", n, 1, dropRestarted, [&]() { firstSale(true); });
+    runner.run("lazy_full_build", n, n, dropRestarted, [&]()
+    {
+        restarted.reset(new InventoryManager());
+        restarted->openLazy("snapshot.txt");
+        restarted->size();
+    });
+    restarted.reset();
+
+    runner.run("mixed_workload", n, ops.size(), freshHistory, [&]()
+    {
+        CoutSilencer quiet;
+        for (const Op &op : ops)
+        {
+            Medicine *med = op.kind == OpKind::ExpirySweep ? nullptr : manager.findBatch(op.batch);
+            switch (op.kind)
+            {
+            case OpKind::Sale:
+                bill.clear();
+                if (med)
+                    manager.sellBatch(*med, op.qty, bill);
+                break;
+            case OpKind::Restock:
+                if (med)
+                    med->setQuantity(med->getQuantity() + op.qty);
+                break;
+            case OpKind::ExpirySweep:
+                manager.removeExpired();
+                break;
+            }
+        }
+    });
+
+    runner.run("report_low_stock", n, n, reload, [&]()
+    {
+        CoutSilencer quiet;
+        manager.generateLowStockReport();
+    });
+
+    runner.run("report_expired", n, n, reload, [&]()
+    {
+        CoutSilencer quiet;
+        manager.generateExpiredReport();
+    });
+
+    runner.run("report_inventory", n, n, reload, [&]()
+    {
+        CoutSilencer quiet;
+        manager.displayInventory();
+    });
+
+    runner.run("history_append", n, wspec.ops, freshHistory, [&]()
+    {
+        for (size_t i = 0; i < wspec.ops; i++)
+            manager.writeHistory("Bought 1 of Paracetamol (B0000001), total=3.00");
+    });
+}
+
+static void runReceivingSuite(BenchRunner &runner, size_t n, size_t lines, uint64_t seed)
+{
+    InventorySpec ispec;
+    ispec.batches = n;
+    writeInventory(generateInventory(ispec, seed), "snapshot.txt");
+    writeManifest(lines, n, 0.2, "manifest.txt", seed);
+
+    InventoryManager manager;
+    ReceiptSummary summary;
+    auto reset = [&]()
+    {
+        manager.loadFromFile("snapshot.txt");
+        std::remove("history.txt");
+        fs::remove_all("history_archive");
+    };
+    // ops = manifest lines; includes the single save and history entry.
+    runner.run("receive_manifest", n, lines, reset, [&]() { manager.receiveManifest("manifest.txt", summary); });
+    runner.value("receive_manifest", n, "new_batches", (double)summary.added);
+}
+
+// Synthetic history.txt entries spread evenly over `days`, in the formats
+// prog2.cpp and app.py write: mostly sales, then restocks, updates, adds and
+// expiry marks.
+static std::vector<std::string> generateHistory(size_t lines, size_t batches, int days, uint64_t seed)
+{
+    Rng rng(seed ^ 0x5EEDULL);
+    Zipf popularity(batches, 0.99);
+    const size_t poolSize = sizeof(NAME_POOL) / sizeof(NAME_POOL[0]);
+    std::time_t start = std::time(nullptr) - (std::time_t)days * 86400;
+    double step = days * 86400.0 / std::max<size_t>(lines, 1);
+
+    std::vector<std::string> out;
+    out.reserve(lines);
+    char ts[32];
+    for (size_t i = 0; i < lines; i++)
+    {
+        std::time_t t = start + (std::time_t)(i * step);
+        std::strftime(ts, sizeof(ts), "[%Y-%m-%d %H:%M:%S] ", std::localtime(&t));
+        size_t b = popularity.sample(rng);
+        std::string batch = batchName(b);
+        std::string name = NAME_POOL[b % poolSize];
+        double price = (double)(b * 7919 % 1000 + 1) * 0.5; // fixed per batch
+        int qty = (int)rng.range(1, 20);
+        double r = rng.unit();
+        std::string msg;
+        if (r < 0.80)
+            msg = "Bought " + std::to_string(qty) + " of " + name + " (" + batch + "), total=" +
+                  std::to_string(qty * price);
+        else if (r < 0.90)
+            msg = "Restocked medicine: " + name + " (" + batch + "), added qty=" + std::to_string(qty * 500) +
+                  ", new total=" + std::to_string(qty * 500 + rng.range(0, 5000)) + ", new expiry=unchanged";
+        else if (r < 0.95)
+            msg = "Updated medicine: " + name + " (" + batch + "), new qty=" + std::to_string(rng.range(0, 100000));
+        else if (r < 0.98)
+            msg = "Added medicine: " + name + " (" + batch + "), qty=" + std::to_string(qty * 1000) +
+                  ", price=" + std::to_string(price);
+        else
+            msg = "Marked as expired (qty set to 0): " + name + " (" + batch + "), previous qty=" +
+                  std::to_string(rng.range(1, 5000));
+        out.push_back(ts + msg + "\n");
+    }
+    return out;
+}
+
+static void runHistorySuite(BenchRunner &runner, size_t lines, uint64_t seed)
+{
+    const int days = 180;
+    std::vector<std::string> entries = generateHistory(lines, 10000, days, seed);
+    uint64_t rawBytes = 0;
+    for (const std::string &e : entries)
+        rawBytes += e.size();
+
+    auto reset = []()
+    {
+        std::remove("history.txt");
+        fs::remove_all("history_archive");
+    };
+    runner.run("history_append_rotating", lines, lines, reset, [&]()
+    {
+        HistoryArchive archive;
+        for (const std::string &e : entries)
+            archive.append(e);
+    });
+
+    HistoryArchive().rotate(); // seal the live tail too, so every byte is compressed
+    uint64_t stored = 0;
+    for (auto &seg : fs::directory_iterator("history_archive"))
+        stored += fs::file_size(seg.path());
+    runner.value("history_compression", lines, "ratio", stored ? (double)rawBytes / stored : 0.0);
+
+    // "All sales of one hot batch this quarter".
+    HistoryQuery q;
+    q.needles = {"Bought ", "(" + batchName(0) + ")"};
+    std::time_t quarterAgo = std::time(nullptr) - 90 * 86400;
+    char from[16];
+    std::strftime(from, sizeof(from), "%Y-%m-%d", std::localtime(&quarterAgo));
+    q.from = from;
+
+    HistoryArchive archive;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    auto nothing = []() {};
+    runner.run("history_scan_1_thread", lines, lines, nothing, [&]() { archive.scan(q, 1); });
+    runner.run("history_scan_parallel", lines, lines, nothing, [&]() { archive.scan(q, cores); });
+    runner.value("history_scan_parallel", lines, "threads", cores);
+}
+
+// ===============================
+// Billing
+// ===============================
+// Counter bills at scale: unit prices from 50 paise to Rs 500, mostly small
+// quantities with the odd bulk order of up to 1.5M units, a discount on some
+// lines and one of the GST slabs on each.
+static void generateBill(billing::Bill &bill, size_t lines, uint64_t seed)
+{
+    static const uint32_t TAX_SLABS[] = {0, 500, 1200, 1800, 2800};
+    Rng rng(seed ^ 0xB111B111B111B111ULL);
+    bill.clear();
+    bill.reserve(lines);
+    for (size_t i = 0; i < lines; i++)
+    {
+        int qty = (int)(rng.unit() < 0.01 ? rng.range(100000, 1500000) : rng.range(1, 20));
+        uint32_t discount = rng.unit() < 0.3 ? (uint32_t)rng.range(0, 2000) : 0;
+        bill.addLine(rng.range(50, 50000), qty, discount, TAX_SLABS[rng.next() % 5]);
+    }
+}
+
+// Reference rounding in 128-bit arithmetic, where amount * bp cannot overflow.
+static int64_t referenceBasisPoints(__int128 amount, int64_t bp)
+{
+    return (int64_t)((amount * bp + money::BP_SCALE / 2) / money::BP_SCALE);
+}
+
+// Picks from the edges of a range half the time, where rounding and overflow
+// bugs live, and uniformly otherwise.
+static int64_t edgyRange(Rng &rng, int64_t lo, int64_t hi)
+{
+    const int64_t edges[] = {lo, lo + 1, hi - 1, hi, (lo + hi) / 2};
+    if (rng.next() % 2 == 0)
+        return std::min(hi, std::max(lo, edges[rng.next() % 5]));
+    return rng.range(lo, hi);
+}
+
+// Property check: money parsing/formatting round-trips and every bill line and
+// total matches the 128-bit reference exactly. Returns the number of failures.
+static size_t checkBilling(size_t cases, uint64_t seed)
+{
+    Rng rng(seed ^ 0xC4ECC4ECC4ECC4ECULL);
+    size_t failures = 0;
+    auto fail = [&](const std::string &what)
+    {
+        if (failures++ < 10)
+            std::cerr << "billing check failed: " << what << "\n";
+    };
+
+    for (size_t i = 0; i < cases; i++)
+    {
+        money::Paise p = edgyRange(rng, -(INT64_MAX / 100), INT64_MAX / 100);
+        std::string shortest, fixed = money::format(p);
+        money::append(shortest, p);
+        money::Paise back1 = 0, back2 = 0;
+        if (!money::parse(shortest, back1) || back1 != p || !money::parse(fixed, back2) || back2 != p)
+            fail("round trip of " + std::to_string(p) + " paise via " + shortest + " / " + fixed);
+
+        // Three decimals round half up in the third place.
+        int64_t whole = rng.range(0, 1000000000), thousandths = rng.range(0, 999);
+        char text[48];
+        std::snprintf(text, sizeof(text), "%lld.%03lld", (long long)whole, (long long)thousandths);
+        money::Paise parsed = 0;
+        if (!money::parse(text, text + std::strlen(text), parsed) ||
+            parsed != whole * 100 + thousandths / 10 + (thousandths % 10 >= 5))
+            fail(std::string("parse of ") + text);
+    }
+
+    // Lines across the full input range, one bill per line so totals cannot overflow.
+    billing::Bill bill;
+    for (size_t i = 0; i < cases; i++)
+    {
+        bill.clear();
+        bill.addLine(edgyRange(rng, 0, UINT32_MAX), (int)edgyRange(rng, 0, INT32_MAX),
+                     (uint32_t)edgyRange(rng, 0, 10000), (uint32_t)edgyRange(rng, 0, 10000));
+        bill.total();
+        __int128 gross = (__int128)bill.unitPaise[0] * bill.qty[0];
+        int64_t discount = referenceBasisPoints(gross, bill.discountBp[0]);
+        int64_t tax = referenceBasisPoints(gross - discount, bill.taxBp[0]);
+        if (bill.gross[0] != (int64_t)gross || bill.discount[0] != discount || bill.tax[0] != tax ||
+            bill.net[0] != (int64_t)(gross - discount + tax) || bill.lineNet(0) != bill.net[0])
+            fail("line " + std::to_string(bill.unitPaise[0]) + " x " + std::to_string(bill.qty[0]) + " at " +
+                 std::to_string(bill.discountBp[0]) + "/" + std::to_string(bill.taxBp[0]) + " bp");
+    }
+
+    // Whole realistic bills: totals are the exact sums of the rounded lines.
+    for (size_t b = 0; b < 20; b++)
+    {
+        generateBill(bill, 1 + rng.next() % 5000, seed + b);
+        billing::Totals totals = bill.total();
+        __int128 gross = 0, discount = 0, tax = 0;
+        for (size_t i = 0; i < bill.size(); i++)
+        {
+            __int128 g = (__int128)bill.unitPaise[i] * bill.qty[i];
+            int64_t d = referenceBasisPoints(g, bill.discountBp[i]);
+            gross += g;
+            discount += d;
+            tax += referenceBasisPoints(g - d, bill.taxBp[i]);
+        }
+        if (totals.gross != (int64_t)gross || totals.discount != (int64_t)discount ||
+            totals.tax != (int64_t)tax || totals.net != (int64_t)(gross - discount + tax))
+            fail("totals of bill " + std::to_string(b));
+    }
+    return failures;
+}
+
+static void runBillingSuite(BenchRunner &runner, size_t lines, uint64_t seed)
+{
+    billing::Bill bill;
+    generateBill(bill, lines, seed);
+    runner.run("bill_total", lines, lines, []() {}, [&]() { bill.total(); });
+
+    // The float accumulation buyMedicines used before, on the same lines' gross amounts.
+    float floatTotal = 0.0f;
+    runner.run("bill_total_float", lines, lines, [&]() { floatTotal = 0.0f; }, [&]()
+    {
+        for (size_t i = 0; i < lines; i++)
+            floatTotal += bill.qty[i] * (bill.unitPaise[i] / 100.0f);
+    });
+    billing::Totals totals = bill.total();
+    runner.value("bill_total_float", lines, "drift_paise",
+                 std::fabs((double)floatTotal * 100.0 - (double)totals.gross));
+}
+
+// ===============================
+// Main
+// ===============================
+static std::vector<size_t> parseSizes(const std::string &list)
+{
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    std::string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            sizes.push_back(std::stoul(item));
+    return sizes;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> sizes = {1000, 10000};
+    WorkloadSpec wspec;
+    int reps = 3;
+    uint64_t seed = 42;
+    size_t historyLines = 200000;
+    size_t manifestLines = 100000;
+    size_t billLines = 1000000;
+    std::string outFile, metricsFile;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--gen-inventory" && i + 2 < argc)
+        {
+            InventorySpec spec;
+            spec.batches = std::stoul(argv[i + 1]);
+            writeInventory(generateInventory(spec, seed), argv[i + 2]);
+            return 0;
+        }
+        else if (arg == "--n" && hasValue)
+            sizes = parseSizes(argv[++i]);
+        else if (arg == "--history" && hasValue)
+            historyLines = std::stoul(argv[++i]);
+        else if (arg == "--manifest" && hasValue)
+            manifestLines = std::stoul(argv[++i]);
+        else if (arg == "--bill" && hasValue)
+            billLines = std::stoul(argv[++i]);
+        else if (arg == "--ops" && hasValue)
+            wspec.ops = std::stoul(argv[++i]);
+        else if (arg == "--reps" && hasValue)
+            reps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed" && hasValue)
+            seed = std::stoull(argv[++i]);
+        else if (arg == "--out" && hasValue)
+            outFile = fs::absolute(argv[++i]).string();
+        else if (arg == "--metrics" && hasValue)
+            metricsFile = fs::absolute(argv[++i]).string();
+        else
+        {
+            std::cerr << "usage: bench [--n N[,N...]] [--ops OPS] [--reps R] [--seed S] [--history LINES]\n"
+                      << "             [--manifest LINES] [--bill LINES] [--out FILE] [--metrics FILE]\n"
+                      << "       bench --gen-inventory N FILE\n";
+            return 2;
+        }
+    }
+
+    // Exact money is a correctness property, so a mismatch fails the whole run.
+    size_t failures = checkBilling(100000, seed);
+    if (failures > 0)
+    {
+        std::cerr << failures << " billing check failures\n";
+        return 1;
+    }
+
+    fs::path scratch = fs::temp_directory_path() / ("medinv-bench-" + std::to_string(seed));
+    fs::create_directories(scratch);
+    fs::path home = fs::current_path();
+    fs::current_path(scratch);
+
+    failures = checkBackupCsv(seed);
+    if (failures > 0)
+    {
+        std::cerr << failures << " backup csv check failures\n";
+        fs::current_path(home);
+        fs::remove_all(scratch);
+        return 1;
+    }
+
+    BenchRunner runner(reps, outFile);
+    for (size_t n : sizes)
+        runSuite(runner, n, wspec, seed);
+    if (manifestLines > 0)
+        for (size_t n : sizes)
+            runReceivingSuite(runner, n, manifestLines, seed);
+    if (historyLines > 0)
+        runHistorySuite(runner, historyLines, seed);
+    if (billLines > 0)
+        runBillingSuite(runner, billLines, seed);
+
+    fs::current_path(home);
+    fs::remove_all(scratch);
+    if (!metricsFile.empty())
+        metrics::dumpToFile(metricsFile);
+    return 0;
+}
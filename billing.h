@@ -0,0 +1,138 @@
+// billing.h - exact bill totals in integer paise.
+//
+// A Bill keeps its lines as parallel arrays (structure of arrays) rather than
+// a vector of line objects, so totalling is two straight loops over
+// contiguous integers with no branches and no floating point. The gross pass
+// is one widening 32x32 multiply per line and vectorizes. The rounding pass
+// stays scalar because SIMD units have no 64-bit multiply-high for the
+// divisions by BP_SCALE, but it is branch-free multiply/shift code.
+//
+// Per line, with rates in basis points:
+//   gross    = unit * qty
+//   discount = round(gross * discountBp / 10000)
+//   tax      = round((gross - discount) * taxBp / 10000)
+//   net      = gross - discount + tax
+// where round() is half up (money::applyBasisPoints). Each line is rounded on
+// its own, as on a printed invoice, and the bill totals are exact sums of the
+// rounded lines.
+#ifndef MEDINV_BILLING_H
+#define MEDINV_BILLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "money.h"
+
+namespace billing
+{
+    struct Totals
+    {
+        money::Paise gross = 0;
+        money::Paise discount = 0;
+        money::Paise tax = 0;
+        money::Paise net = 0;
+    };
+
+    // Unit prices fit in 32 bits (up to about 4.29 crore rupees) and quantities
+    // in 31, so a line's gross stays below 2^63 (bill totals are assumed to
+    // as well). Rates are 0..10000 bp. addLine refuses anything outside these.
+    class Bill
+    {
+    public:
+        std::vector<uint32_t> unitPaise;
+        std::vector<uint32_t> qty;
+        std::vector<uint32_t> discountBp;
+        std::vector<uint32_t> taxBp; // charged on the discounted amount
+
+        // Per-line results, filled in by total().
+        std::vector<money::Paise> gross, discount, tax, net;
+
+        size_t size() const { return unitPaise.size(); }
+
+        void reserve(size_t n)
+        {
+            unitPaise.reserve(n);
+            qty.reserve(n);
+            discountBp.reserve(n);
+            taxBp.reserve(n);
+        }
+
+        void clear()
+        {
+            unitPaise.clear();
+            qty.clear();
+            discountBp.clear();
+            taxBp.clear();
+            gross.clear();
+            discount.clear();
+            tax.clear();
+            net.clear();
+        }
+
+        static bool fits(money::Paise unit, int quantity, uint32_t discount = 0, uint32_t taxRate = 0)
+        {
+            return unit >= 0 && unit <= (money::Paise)UINT32_MAX && quantity >= 0 &&
+                   discount <= money::BP_SCALE && taxRate <= money::BP_SCALE;
+        }
+
+        // Returns false, adding nothing, if the line does not fit (see fits()).
+        bool addLine(money::Paise unit, int quantity, uint32_t discount = 0, uint32_t taxRate = 0)
+        {
+            if (!fits(unit, quantity, discount, taxRate))
+                return false;
+            unitPaise.push_back((uint32_t)unit);
+            qty.push_back((uint32_t)quantity);
+            discountBp.push_back(discount);
+            taxBp.push_back(taxRate);
+            return true;
+        }
+
+        // Net of line i alone, rounded exactly as total() rounds it. Lets a
+        // caller price the line it just added without re-totalling the bill.
+        money::Paise lineNet(size_t i) const
+        {
+            money::Paise g = (money::Paise)((uint64_t)unitPaise[i] * qty[i]);
+            money::Paise off = money::applyBasisPoints(g, discountBp[i]);
+            return g - off + money::applyBasisPoints(g - off, taxBp[i]);
+        }
+
+        Totals total()
+        {
+            const size_t n = size();
+            gross.resize(n);
+            discount.resize(n);
+            tax.resize(n);
+            net.resize(n);
+
+            const uint32_t *u = unitPaise.data();
+            const uint32_t *q = qty.data();
+            const uint32_t *d = discountBp.data();
+            const uint32_t *t = taxBp.data();
+            money::Paise *g = gross.data();
+            money::Paise *dc = discount.data();
+            money::Paise *tx = tax.data();
+            money::Paise *nt = net.data();
+
+            for (size_t i = 0; i < n; i++)
+                g[i] = (money::Paise)((uint64_t)u[i] * q[i]);
+
+            Totals totals;
+            for (size_t i = 0; i < n; i++)
+            {
+                money::Paise off = money::applyBasisPoints(g[i], d[i]);
+                money::Paise levy = money::applyBasisPoints(g[i] - off, t[i]);
+                dc[i] = off;
+                tx[i] = levy;
+                nt[i] = g[i] - off + levy;
+                totals.gross += g[i];
+                totals.discount += off;
+                totals.tax += levy;
+                totals.net += nt[i];
+            }
+            return totals;
+        }
+    };
+}
+
+#endif
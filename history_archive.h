@@ -0,0 +1,1020 @@
+// history_archive.h - size/day rotated, compressed history segments.
+//
+// history.txt stays the live, plain-text log that app.py and the console read.
+// When it grows past the size limit (or, if enabled, a new day starts) it is
+// sealed into history_archive/history-<seq>-<first timestamp>.mhz, where <seq>
+// is a zero-padded counter so that name order is sealing order. Sealing first
+// renames history.txt to history.txt.sealing, so app.py's next log() (which
+// reopens the path for every entry) starts a fresh file instead of writing into
+// one about to be truncated; the renamed file is removed only once its segment
+// has been written.
+//
+// Segment layout (all integers little-endian):
+//   "MHZ1"
+//   block 0 .. block N-1          compressed runs of whole log lines, <= 256 KiB raw each
+//                                 (see historylz below for the block encoding)
+//   index: N entries of           u64 offset, u32 compressed size, u32 raw size,
+//                                 u32 line count, char[19] first ts, char[19] last ts
+//   footer: u32 N, u64 index offset, "MHZI"
+//
+// Blocks are compressed independently, so a scan can skip blocks by timestamp
+// and decompress the rest on every core.
+#ifndef MEDINV_HISTORY_ARCHIVE_H
+#define MEDINV_HISTORY_ARCHIVE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <cstdio>
+#include <fstream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace historylz
+{
+    // Each block goes through three reversible stages:
+    //   1. line model: "[YYYY-MM-DD HH:MM:SS] " becomes a varint delta from the
+    //      previous line and stock phrases ("Restocked medicine: ", ...) become
+    //      single control bytes;
+    //   2. LZ4-style sequences: token (literal length << 4 | match length - 4),
+    //      optional 255-run length bytes, literals, u16 offset, optional match
+    //      length bytes; the final sequence carries literals only;
+    //   3. canonical Huffman over the LZ bytes, kept only if it is smaller.
+    const int MIN_MATCH = 4;
+    const int HASH_BITS = 14;
+    const size_t MAX_OFFSET = 65535;
+    const int HUFF_BITS = 12; // longest code; also the decode table width
+
+    const char ESCAPE = 0x1F;
+    const char LINE_STAMPED = 'T';
+    const char LINE_RAW = 'R';
+
+    // Message phrases written by prog2.cpp and app.py. Codes skip '\t', '\n' and '\r'.
+    static const char *const PHRASES[] = {
+        "Marked as expired (qty set to 0): ", "Removed expired medicine: ", "Restocked medicine: ",
+        "Updated medicine: ", "Added medicine: ", ", new expiry=unchanged", ", new expiry=",
+        ", new total=", "), added qty=", "), previous qty=", "), new qty=", "), total=", "), qty=",
+        ", price=", "Bought ", " of ", ".000000", "Inventory backup downloaded - "};
+    static const unsigned char PHRASE_CODES[] = {1, 2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20, 21};
+    const int PHRASE_COUNT = sizeof(PHRASE_CODES);
+
+    inline int phraseForCode(unsigned char c)
+    {
+        for (int k = 0; k < PHRASE_COUNT; k++)
+            if (PHRASE_CODES[k] == c)
+                return k;
+        return -1;
+    }
+
+    inline uint32_t read32(const char *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    inline void putVarint(std::string &out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)v);
+    }
+
+    inline bool getVarint(const char *src, size_t n, size_t &ip, uint64_t &v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64 && ip < n; shift += 7)
+        {
+            unsigned char b = (unsigned char)src[ip++];
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // ---- stage 1: line model ----
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar (H. Hinnant's algorithm).
+    inline int64_t daysFromCivil(int64_t y, int m, int d)
+    {
+        y -= m <= 2;
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        int64_t yoe = y - era * 400;
+        int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    inline void civilFromDays(int64_t z, int64_t &y, int &m, int &d)
+    {
+        z += 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        int64_t doe = z - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        d = (int)(doy - (153 * mp + 2) / 5 + 1);
+        m = (int)(mp < 10 ? mp + 3 : mp - 9);
+        y = yoe + era * 400 + (m <= 2);
+    }
+
+    inline void formatTimestamp(int64_t secs, char out[20])
+    {
+        int64_t days = secs >= 0 ? secs / 86400 : (secs - 86399) / 86400;
+        int64_t rem = secs - days * 86400, y;
+        int m, d;
+        civilFromDays(days, y, m, d);
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", (int)y, m, d,
+                      (int)(rem / 3600), (int)(rem / 60 % 60), (int)(rem % 60));
+        std::memcpy(out, buf, 19);
+        out[19] = '\0';
+    }
+
+    // Parses "YYYY-MM-DD HH:MM:SS" as zone-less seconds; fails unless it formats back identically.
+    inline bool parseTimestamp(const char *p, int64_t &secs)
+    {
+        static const char SHAPE[] = "dddd-dd-dd dd:dd:dd";
+        int v[6] = {0, 0, 0, 0, 0, 0}, field = 0;
+        for (int i = 0; i < 19; i++)
+        {
+            if (SHAPE[i] == 'd')
+            {
+                if (p[i] < '0' || p[i] > '9')
+                    return false;
+                v[field] = v[field] * 10 + (p[i] - '0');
+            }
+            else if (p[i] != SHAPE[i])
+                return false;
+            else
+                field++;
+        }
+        if (v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > 31 || v[3] > 23 || v[4] > 59 || v[5] > 59)
+            return false;
+        secs = daysFromCivil(v[0], v[1], v[2]) * 86400 + v[3] * 3600 + v[4] * 60 + v[5];
+        char check[20];
+        formatTimestamp(secs, check);
+        return std::memcmp(check, p, 19) == 0;
+    }
+
+    inline std::string encodeLines(const char *src, size_t n)
+    {
+        std::vector<int> byFirstChar[256];
+        for (int k = 0; k < PHRASE_COUNT; k++)
+            byFirstChar[(unsigned char)PHRASES[k][0]].push_back(k);
+        bool isCode[256] = {};
+        for (int k = 0; k < PHRASE_COUNT; k++)
+            isCode[PHRASE_CODES[k]] = true;
+        isCode[(unsigned char)ESCAPE] = true;
+
+        std::string out;
+        out.reserve(n / 2);
+        int64_t prev = 0;
+        size_t pos = 0;
+        while (pos < n)
+        {
+            const char *eol = static_cast<const char *>(std::memchr(src + pos, '\n', n - pos));
+            size_t end = eol ? (size_t)(eol - src) : n;
+            int64_t secs;
+            if (end - pos >= 22 && src[pos] == '[' && src[pos + 20] == ']' && src[pos + 21] == ' ' &&
+                parseTimestamp(src + pos + 1, secs))
+            {
+                int64_t delta = secs - prev;
+                prev = secs;
+                out.push_back(LINE_STAMPED);
+                putVarint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+                pos += 22;
+            }
+            else
+                out.push_back(LINE_RAW);
+
+            while (pos < end)
+            {
+                unsigned char c = (unsigned char)src[pos];
+                int hit = -1;
+                for (int k : byFirstChar[c])
+                {
+                    size_t len = std::strlen(PHRASES[k]);
+                    if (len <= end - pos && std::memcmp(src + pos, PHRASES[k], len) == 0)
+                    {
+                        hit = k;
+                        break;
+                    }
+                }
+                if (hit >= 0)
+                {
+                    out.push_back((char)PHRASE_CODES[hit]);
+                    pos += std::strlen(PHRASES[hit]);
+                    continue;
+                }
+                if (isCode[c])
+                    out.push_back(ESCAPE);
+                out.push_back((char)c);
+                pos++;
+            }
+            out.push_back('\n');
+            pos = end + 1;
+        }
+        return out;
+    }
+
+    // Every decoded line ends in '\n'; rawSize tells whether the original's last one did.
+    inline bool decodeLines(const char *src, size_t n, size_t rawSize, std::string &out)
+    {
+        out.clear();
+        out.reserve(rawSize + 1);
+        int64_t prev = 0;
+        size_t ip = 0;
+        while (ip < n)
+        {
+            char kind = src[ip++];
+            if (kind == LINE_STAMPED)
+            {
+                uint64_t z;
+                if (!getVarint(src, n, ip, z))
+                    return false;
+                prev += (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+                char ts[20];
+                formatTimestamp(prev, ts);
+                out.push_back('[');
+                out.append(ts, 19);
+                out.append("] ");
+            }
+            else if (kind != LINE_RAW)
+                return false;
+
+            for (;;)
+            {
+                if (ip >= n)
+                    return false;
+                unsigned char c = (unsigned char)src[ip++];
+                if (c == '\n')
+                    break;
+                int k = phraseForCode(c);
+                if (k >= 0)
+                    out.append(PHRASES[k]);
+                else if (c == (unsigned char)ESCAPE)
+                {
+                    if (ip >= n)
+                        return false;
+                    out.push_back(src[ip++]);
+                }
+                else
+                    out.push_back((char)c);
+            }
+            out.push_back('\n');
+            if (out.size() > rawSize + 1)
+                return false;
+        }
+        if (out.size() == rawSize + 1)
+            out.pop_back();
+        return out.size() == rawSize;
+    }
+
+    // ---- stage 2: LZ ----
+
+    inline void putLength(std::string &out, size_t len)
+    {
+        while (len >= 255)
+        {
+            out.push_back((char)255);
+            len -= 255;
+        }
+        out.push_back((char)len);
+    }
+
+    inline void emit(std::string &out, const char *lit, size_t litLen, size_t offset, size_t matchLen)
+    {
+        size_t m = matchLen ? matchLen - MIN_MATCH : 0;
+        out.push_back((char)((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(m, 15)));
+        if (litLen >= 15)
+            putLength(out, litLen - 15);
+        out.append(lit, litLen);
+        if (!matchLen)
+            return;
+        out.push_back((char)(offset & 0xFF));
+        out.push_back((char)(offset >> 8));
+        if (m >= 15)
+            putLength(out, m - 15);
+    }
+
+    // Longest earlier match for position i, following up to MAX_CHAIN hash-chain links.
+    inline size_t longestMatch(const char *src, size_t n, size_t i, const std::vector<int64_t> &head,
+                               const std::vector<int64_t> &chain, size_t &offset)
+    {
+        const int MAX_CHAIN = 32;
+        size_t best = 0;
+        uint32_t seq = read32(src + i);
+        int64_t cand = head[(seq * 2654435761u) >> (32 - HASH_BITS)];
+        for (int depth = 0; cand >= 0 && depth < MAX_CHAIN && i - (size_t)cand <= MAX_OFFSET; depth++)
+        {
+            if (i + best >= n)
+                break;
+            if (read32(src + cand) == seq && src[cand + best] == src[i + best])
+            {
+                size_t len = MIN_MATCH;
+                while (i + len < n && src[cand + len] == src[i + len])
+                    len++;
+                if (len > best)
+                {
+                    best = len;
+                    offset = i - (size_t)cand;
+                }
+            }
+            cand = chain[(size_t)cand & MAX_OFFSET];
+        }
+        return best;
+    }
+
+    inline std::string lzCompress(const char *src, size_t n)
+    {
+        std::string out;
+        out.reserve(n / 2 + 16);
+        std::vector<int64_t> head((size_t)1 << HASH_BITS, -1), chain(MAX_OFFSET + 1, -1);
+        size_t inserted = 0;
+        auto insertUpTo = [&](size_t end)
+        {
+            for (; inserted < end && inserted + MIN_MATCH <= n; inserted++)
+            {
+                uint32_t h = (read32(src + inserted) * 2654435761u) >> (32 - HASH_BITS);
+                chain[inserted & MAX_OFFSET] = head[h];
+                head[h] = (int64_t)inserted;
+            }
+        };
+
+        size_t anchor = 0, i = 0;
+        while (i + MIN_MATCH <= n)
+        {
+            insertUpTo(i);
+            size_t offset = 0;
+            size_t len = longestMatch(src, n, i, head, chain, offset);
+            if (len < MIN_MATCH)
+            {
+                i++;
+                continue;
+            }
+            // Lazy step: prefer a literal now if the next position matches longer.
+            if (i + 1 + MIN_MATCH <= n)
+            {
+                insertUpTo(i + 1);
+                size_t nextOffset = 0;
+                if (longestMatch(src, n, i + 1, head, chain, nextOffset) > len + 1)
+                {
+                    i++;
+                    continue;
+                }
+            }
+            emit(out, src + anchor, i - anchor, offset, len);
+            i += len;
+            anchor = i;
+        }
+        emit(out, src + anchor, n - anchor, 0, 0);
+        return out;
+    }
+
+    // Returns false if the input is corrupt or does not expand to exactly rawSize bytes.
+    inline bool lzDecompress(const char *src, size_t n, size_t rawSize, std::string &out)
+    {
+        out.clear();
+        out.reserve(rawSize);
+        size_t ip = 0;
+        auto readLength = [&](size_t &len) -> bool
+        {
+            unsigned char b;
+            do
+            {
+                if (ip >= n)
+                    return false;
+                b = (unsigned char)src[ip++];
+                len += b;
+            } while (b == 255);
+            return true;
+        };
+        while (ip < n)
+        {
+            unsigned char token = (unsigned char)src[ip++];
+            size_t litLen = token >> 4;
+            if (litLen == 15 && !readLength(litLen))
+                return false;
+            if (litLen > n - ip || out.size() + litLen > rawSize)
+                return false;
+            out.append(src + ip, litLen);
+            ip += litLen;
+            if (ip == n)
+                break;
+            if (n - ip < 2)
+                return false;
+            size_t offset = (unsigned char)src[ip] | ((size_t)(unsigned char)src[ip + 1] << 8);
+            ip += 2;
+            size_t matchLen = token & 15;
+            if (matchLen == 15 && !readLength(matchLen))
+                return false;
+            matchLen += MIN_MATCH;
+            if (offset == 0 || offset > out.size() || out.size() + matchLen > rawSize)
+                return false;
+            size_t from = out.size() - offset;
+            for (size_t k = 0; k < matchLen; k++) // may overlap its own output
+                out.push_back(out[from + k]);
+        }
+        return out.size() == rawSize;
+    }
+
+    // ---- stage 3: Huffman ----
+
+    // Code lengths no longer than HUFF_BITS; frequencies are halved until the tree fits.
+    inline void huffmanLengths(const uint64_t freq[256], uint8_t len[256])
+    {
+        std::vector<uint64_t> f(freq, freq + 256);
+        for (;;)
+        {
+            std::fill(len, len + 256, 0);
+            std::vector<uint64_t> weight;
+            std::vector<int> parent;
+            std::priority_queue<std::pair<uint64_t, int>, std::vector<std::pair<uint64_t, int>>,
+                                std::greater<std::pair<uint64_t, int>>>
+                heap;
+            int leaves[256], used = 0;
+            for (int s = 0; s < 256; s++)
+            {
+                if (!f[s])
+                    continue;
+                leaves[used++] = s;
+                heap.push({f[s], (int)weight.size()});
+                weight.push_back(f[s]);
+                parent.push_back(-1);
+            }
+            if (used == 0)
+                return;
+            if (used == 1)
+            {
+                len[leaves[0]] = 1;
+                return;
+            }
+            while (heap.size() > 1)
+            {
+                auto a = heap.top();
+                heap.pop();
+                auto b = heap.top();
+                heap.pop();
+                int node = (int)weight.size();
+                weight.push_back(a.first + b.first);
+                parent.push_back(-1);
+                parent[a.second] = parent[b.second] = node;
+                heap.push({a.first + b.first, node});
+            }
+            int longest = 0;
+            for (int i = 0; i < used; i++)
+            {
+                int depth = 0;
+                for (int p = i; parent[p] >= 0; p = parent[p])
+                    depth++;
+                len[leaves[i]] = (uint8_t)depth;
+                longest = std::max(longest, depth);
+            }
+            if (longest <= HUFF_BITS)
+                return;
+            for (uint64_t &x : f)
+                if (x)
+                    x = (x + 1) / 2;
+        }
+    }
+
+    // Canonical codes: shorter first, ties by symbol value.
+    inline void huffmanCodes(const uint8_t len[256], uint16_t code[256])
+    {
+        int count[HUFF_BITS + 1] = {};
+        for (int s = 0; s < 256; s++)
+            count[len[s]]++;
+        count[0] = 0;
+        uint16_t next[HUFF_BITS + 2] = {};
+        for (int l = 1; l <= HUFF_BITS; l++)
+            next[l + 1] = (uint16_t)((next[l] + count[l]) << 1);
+        for (int s = 0; s < 256; s++)
+            if (len[s])
+                code[s] = next[len[s]]++;
+    }
+
+    inline std::string huffmanEncode(const std::string &src)
+    {
+        uint64_t freq[256] = {};
+        for (unsigned char c : src)
+            freq[c]++;
+        uint8_t len[256];
+        uint16_t code[256] = {};
+        huffmanLengths(freq, len);
+        huffmanCodes(len, code);
+
+        std::string out;
+        out.reserve(128 + src.size() * 3 / 4);
+        for (int s = 0; s < 256; s += 2)
+            out.push_back((char)(len[s] | (len[s + 1] << 4)));
+        uint64_t acc = 0;
+        int bits = 0;
+        for (unsigned char c : src)
+        {
+            acc = (acc << len[c]) | code[c];
+            bits += len[c];
+            while (bits >= 8)
+            {
+                bits -= 8;
+                out.push_back((char)(acc >> bits));
+            }
+        }
+        if (bits > 0)
+            out.push_back((char)(acc << (8 - bits)));
+        return out;
+    }
+
+    inline bool huffmanDecode(const char *src, size_t n, size_t outSize, std::string &out)
+    {
+        if (n < 128)
+            return false;
+        uint8_t len[256];
+        for (int s = 0; s < 256; s += 2)
+        {
+            len[s] = (uint8_t)(src[s / 2] & 0x0F);
+            len[s + 1] = (uint8_t)((unsigned char)src[s / 2] >> 4);
+            if (len[s] > HUFF_BITS || len[s + 1] > HUFF_BITS)
+                return false;
+        }
+        uint16_t code[256] = {};
+        huffmanCodes(len, code);
+        // Every HUFF_BITS-bit window maps straight to (symbol, code length).
+        std::vector<uint16_t> table((size_t)1 << HUFF_BITS, 0);
+        for (int s = 0; s < 256; s++)
+        {
+            if (!len[s])
+                continue;
+            size_t first = (size_t)code[s] << (HUFF_BITS - len[s]);
+            size_t span = (size_t)1 << (HUFF_BITS - len[s]);
+            if (first + span > table.size())
+                return false;
+            for (size_t i = 0; i < span; i++)
+                table[first + i] = (uint16_t)((s << 4) | len[s]);
+        }
+
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src + 128);
+        size_t nbytes = n - 128, totalBits = nbytes * 8, bitPos = 0;
+        out.clear();
+        out.reserve(outSize);
+        for (size_t i = 0; i < outSize; i++)
+        {
+            size_t at = bitPos >> 3;
+            uint32_t window = 0;
+            for (size_t k = 0; k < 3; k++)
+                window = (window << 8) | (at + k < nbytes ? bytes[at + k] : 0);
+            uint16_t entry = table[(window >> (12 - (bitPos & 7))) & ((1u << HUFF_BITS) - 1)];
+            if (!(entry & 15))
+                return false;
+            bitPos += entry & 15;
+            if (bitPos > totalBits)
+                return false;
+            out.push_back((char)(entry >> 4));
+        }
+        return true;
+    }
+
+    // ---- block framing: method byte, u32 LZ size, payload ----
+
+    const char METHOD_LZ = 0;
+    const char METHOD_LZ_HUFFMAN = 1;
+
+    inline std::string compress(const char *src, size_t n)
+    {
+        std::string modeled = encodeLines(src, n);
+        std::string lz = lzCompress(modeled.data(), modeled.size());
+        std::string huff = huffmanEncode(lz);
+        bool useHuffman = huff.size() < lz.size();
+        std::string out(1, useHuffman ? METHOD_LZ_HUFFMAN : METHOD_LZ);
+        uint32_t lzSize = (uint32_t)lz.size(), modeledSize = (uint32_t)modeled.size();
+        for (int i = 0; i < 4; i++)
+            out.push_back((char)(lzSize >> (8 * i)));
+        for (int i = 0; i < 4; i++)
+            out.push_back((char)(modeledSize >> (8 * i)));
+        out += useHuffman ? huff : lz;
+        return out;
+    }
+
+    inline bool decompress(const char *src, size_t n, size_t rawSize, std::string &out)
+    {
+        if (n < 9)
+            return false;
+        uint32_t lzSize = 0, modeledSize = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            lzSize |= (uint32_t)(unsigned char)src[1 + i] << (8 * i);
+            modeledSize |= (uint32_t)(unsigned char)src[5 + i] << (8 * i);
+        }
+        std::string lz, modeled;
+        if (src[0] == METHOD_LZ_HUFFMAN)
+        {
+            if (!huffmanDecode(src + 9, n - 9, lzSize, lz))
+                return false;
+        }
+        else if (src[0] == METHOD_LZ)
+            lz.assign(src + 9, n - 9);
+        else
+            return false;
+        if (lz.size() != lzSize || !lzDecompress(lz.data(), lz.size(), modeledSize, modeled))
+            return false;
+        return decodeLines(modeled.data(), modeled.size(), rawSize, out);
+    }
+}
+
+// Audit filter: timestamps compare as "YYYY-MM-DD HH:MM:SS" strings, so a
+// bare date works as a bound. `to` is inclusive of everything it prefixes.
+// A line matches only if it contains every needle.
+struct HistoryQuery
+{
+    std::string from;
+    std::string to;
+    std::vector<std::string> needles;
+
+    bool inRange(const std::string &ts) const
+    {
+        if (!from.empty() && ts.compare(0, from.size(), from) < 0)
+            return false;
+        if (!to.empty() && ts.compare(0, to.size(), to) > 0)
+            return false;
+        return true;
+    }
+
+    bool matches(const char *line, size_t len) const
+    {
+        if (!from.empty() || !to.empty())
+        {
+            if (len < 21 || line[0] != '[')
+                return false;
+            if (!inRange(std::string(line + 1, 19)))
+                return false;
+        }
+        for (const std::string &needle : needles)
+            if (std::search(line, line + len, needle.begin(), needle.end()) == line + len)
+                return false;
+        return true;
+    }
+};
+
+class HistoryArchive
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+    static constexpr size_t TS_LEN = 19;
+
+    struct BlockInfo
+    {
+        uint64_t offset;
+        uint32_t compressedSize;
+        uint32_t rawSize;
+        uint32_t lines;
+        std::string firstTs;
+        std::string lastTs;
+    };
+
+private:
+    std::string activePath;
+    std::string archiveDir;
+    uint64_t maxBytes;
+    bool rotateDaily;
+
+    static void put32(std::string &out, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            out.push_back((char)(v >> (8 * i)));
+    }
+
+    static void put64(std::string &out, uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+            out.push_back((char)(v >> (8 * i)));
+    }
+
+    static uint64_t get(const char *p, int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++)
+            v |= (uint64_t)(unsigned char)p[i] << (8 * i);
+        return v;
+    }
+
+    static std::string timestampOf(const char *line, size_t len)
+    {
+        if (len >= TS_LEN + 1 && line[0] == '[')
+            return std::string(line + 1, TS_LEN);
+        return std::string(TS_LEN, ' ');
+    }
+
+    // The live file is re-examined on every append rather than tracked here:
+    // app.py grows it too, and may start a new one after a rotation.
+    uint64_t liveBytes() const
+    {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(activePath, ec);
+        return ec ? 0 : size;
+    }
+
+    // "YYYY-MM-DD" of the oldest live entry.
+    std::string liveDay() const
+    {
+        std::ifstream in(activePath, std::ios::binary);
+        std::string first;
+        getline(in, first);
+        return timestampOf(first.data(), first.size()).substr(0, 10);
+    }
+
+    static constexpr size_t SEQ_DIGITS = 8;
+
+    // Sequence number of a segment file name, or 0 for names without one.
+    static uint64_t sequenceOf(const std::string &path)
+    {
+        std::string name = std::filesystem::path(path).filename().string();
+        const std::string prefix = "history-";
+        if (name.size() < prefix.size() + SEQ_DIGITS + 1 || name.compare(0, prefix.size(), prefix) != 0 ||
+            name[prefix.size() + SEQ_DIGITS] != '-')
+            return 0;
+        uint64_t seq = 0;
+        for (size_t i = prefix.size(); i < prefix.size() + SEQ_DIGITS; i++)
+        {
+            if (name[i] < '0' || name[i] > '9')
+                return 0;
+            seq = seq * 10 + (uint64_t)(name[i] - '0');
+        }
+        return seq;
+    }
+
+    std::string segmentPathFor(const std::string &firstTs) const
+    {
+        std::string stamp;
+        for (char c : firstTs)
+            if (c >= '0' && c <= '9')
+                stamp.push_back(c);
+        if (stamp.empty())
+            stamp = "undated";
+        std::vector<std::string> existing = segments();
+        uint64_t seq = existing.empty() ? 1 : sequenceOf(existing.back()) + 1;
+        std::string path;
+        do
+        {
+            char num[32];
+            std::snprintf(num, sizeof(num), "%0*llu", (int)SEQ_DIGITS, (unsigned long long)seq++);
+            path = archiveDir + "/history-" + num + "-" + stamp + ".mhz";
+        } while (std::filesystem::exists(path));
+        return path;
+    }
+
+public:
+    explicit HistoryArchive(const std::string &active = "history.txt",
+                            const std::string &dir = "history_archive",
+                            uint64_t maxActiveBytes = 4 * 1024 * 1024, bool daily = false)
+        : activePath(active), archiveDir(dir), maxBytes(maxActiveBytes), rotateDaily(daily) {}
+
+    // Appends one complete "[timestamp] message\n" entry, rotating first if the
+    // live file is over the size limit or the entry starts a new day.
+    void append(const std::string &entry)
+    {
+        uint64_t size = liveBytes();
+        bool full = size > 0 && size + entry.size() > maxBytes;
+        bool newDay = rotateDaily && size > 0 &&
+                      timestampOf(entry.data(), entry.size()).compare(0, 10, liveDay()) != 0;
+        if (full || newDay)
+            rotate();
+        std::ofstream log(activePath, std::ios::app | std::ios::binary);
+        log << entry;
+    }
+
+    // Seals the live file into a compressed segment. Returns the path of the
+    // last segment written, or "" if there was nothing to seal or it failed.
+    std::string rotate()
+    {
+        std::string sealing = activePath + ".sealing";
+        std::string path;
+        // Left over from an interrupted rotation; it holds older entries than the live file.
+        if (std::filesystem::exists(sealing))
+        {
+            path = seal(sealing);
+            if (path.empty())
+                return "";
+        }
+        if (std::rename(activePath.c_str(), sealing.c_str()) == 0)
+        {
+            std::string sealed = seal(sealing);
+            if (!sealed.empty())
+                path = sealed;
+        }
+        return path;
+    }
+
+private:
+    // Compresses the file at source into a new segment, then deletes source.
+    // On failure source is kept, to be sealed by a later rotate().
+    std::string seal(const std::string &source)
+    {
+        std::ifstream in(source, std::ios::binary);
+        std::string raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        if (raw.empty())
+        {
+            std::remove(source.c_str());
+            return "";
+        }
+
+        std::string body = "MHZ1", index;
+        uint32_t blocks = 0;
+        size_t pos = 0;
+        while (pos < raw.size())
+        {
+            // Cut at the last line end within BLOCK_SIZE; an overlong line gets its own block.
+            size_t end = std::min(raw.size(), pos + BLOCK_SIZE);
+            if (end < raw.size())
+            {
+                size_t nl = raw.rfind('\n', end - 1);
+                if (nl == std::string::npos || nl < pos)
+                    nl = raw.find('\n', end);
+                end = nl == std::string::npos ? raw.size() : nl + 1;
+            }
+            const char *p = raw.data() + pos;
+            size_t len = end - pos;
+            uint32_t lines = (uint32_t)std::count(p, p + len, '\n');
+            size_t lastStart = len - 1;
+            while (lastStart > 0 && p[lastStart - 1] != '\n')
+                lastStart--;
+
+            std::string packed = historylz::compress(p, len);
+            put64(index, body.size());
+            put32(index, (uint32_t)packed.size());
+            put32(index, (uint32_t)len);
+            put32(index, lines);
+            index += timestampOf(p, len);
+            index += timestampOf(p + lastStart, len - lastStart);
+            body += packed;
+            blocks++;
+            pos = end;
+        }
+        uint64_t indexOffset = body.size();
+        body += index;
+        put32(body, blocks);
+        put64(body, indexOffset);
+        body += "MHZI";
+
+        std::filesystem::create_directories(archiveDir);
+        std::string path = segmentPathFor(timestampOf(raw.data(), raw.size()));
+        std::ofstream out(path, std::ios::binary);
+        out.write(body.data(), (std::streamsize)body.size());
+        out.close();
+        if (!out)
+        {
+            std::remove(path.c_str());
+            return "";
+        }
+        std::remove(source.c_str());
+        return path;
+    }
+
+public:
+
+    // Sealed segments, oldest (lowest sequence number) first.
+    std::vector<std::string> segments() const
+    {
+        std::vector<std::pair<uint64_t, std::string>> found;
+        std::error_code ec;
+        for (auto &e : std::filesystem::directory_iterator(archiveDir, ec))
+            if (e.path().extension() == ".mhz")
+                found.emplace_back(sequenceOf(e.path().string()), e.path().string());
+        std::sort(found.begin(), found.end());
+        std::vector<std::string> paths;
+        for (auto &f : found)
+            paths.push_back(std::move(f.second));
+        return paths;
+    }
+
+    static bool readIndex(const std::string &path, std::vector<BlockInfo> &blocks)
+    {
+        const size_t FOOTER = 16, ENTRY = 20 + 2 * TS_LEN;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+            return false;
+        uint64_t size = (uint64_t)in.tellg();
+        if (size < 4 + FOOTER)
+            return false;
+        char footer[FOOTER];
+        in.seekg((std::streamoff)(size - FOOTER));
+        in.read(footer, FOOTER);
+        if (!in || std::memcmp(footer + 12, "MHZI", 4) != 0)
+            return false;
+        uint64_t count = get(footer, 4), indexOffset = get(footer + 4, 8);
+        if (indexOffset + count * ENTRY != size - FOOTER)
+            return false;
+        std::string raw(count * ENTRY, '\0');
+        in.seekg((std::streamoff)indexOffset);
+        in.read(&raw[0], (std::streamsize)raw.size());
+        if (!in)
+            return false;
+        blocks.clear();
+        for (uint64_t i = 0; i < count; i++)
+        {
+            const char *e = raw.data() + i * ENTRY;
+            blocks.push_back({get(e, 8), (uint32_t)get(e + 8, 4), (uint32_t)get(e + 12, 4),
+                              (uint32_t)get(e + 16, 4), std::string(e + 20, TS_LEN),
+                              std::string(e + 20 + TS_LEN, TS_LEN)});
+        }
+        return true;
+    }
+
+    // Returns every archived and live line matching q, oldest first. Segment
+    // blocks whose timestamp span misses the range are skipped unread; the
+    // rest are decompressed and filtered on `threads` workers (0 = one per core).
+    // If linesScanned is given it receives the number of lines examined.
+    std::vector<std::string> scan(const HistoryQuery &q, unsigned threads = 0,
+                                  uint64_t *linesScanned = nullptr) const
+    {
+        struct Task
+        {
+            const std::string *path;
+            BlockInfo block;
+        };
+        std::vector<std::string> paths = segments();
+        std::vector<Task> tasks;
+        std::vector<BlockInfo> blocks;
+        uint64_t scanned = 0;
+        for (const std::string &path : paths)
+        {
+            if (!readIndex(path, blocks))
+                continue;
+            for (const BlockInfo &b : blocks)
+            {
+                bool before = !q.from.empty() && b.lastTs.compare(0, q.from.size(), q.from) < 0;
+                bool after = !q.to.empty() && b.firstTs.compare(0, q.to.size(), q.to) > 0;
+                if (!before && !after)
+                {
+                    tasks.push_back({&path, b});
+                    scanned += b.lines;
+                }
+            }
+        }
+
+        std::vector<std::vector<std::string>> found(tasks.size());
+        std::atomic<size_t> next{0};
+        auto worker = [&]()
+        {
+            std::string packed, raw;
+            for (size_t t; (t = next.fetch_add(1)) < tasks.size();)
+            {
+                const BlockInfo &b = tasks[t].block;
+                std::ifstream in(*tasks[t].path, std::ios::binary);
+                packed.resize(b.compressedSize);
+                in.seekg((std::streamoff)b.offset);
+                in.read(&packed[0], (std::streamsize)packed.size());
+                if (!in || !historylz::decompress(packed.data(), packed.size(), b.rawSize, raw))
+                    continue;
+                size_t pos = 0;
+                while (pos < raw.size())
+                {
+                    size_t nl = raw.find('\n', pos);
+                    size_t end = nl == std::string::npos ? raw.size() : nl;
+                    if (end > pos && q.matches(raw.data() + pos, end - pos))
+                        found[t].emplace_back(raw, pos, end - pos);
+                    pos = end + 1;
+                }
+            }
+        };
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = (unsigned)std::min<size_t>(threads, tasks.size());
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; i++)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread &th : pool)
+            th.join();
+
+        std::vector<std::string> lines;
+        for (auto &f : found)
+            for (auto &line : f)
+                lines.push_back(std::move(line));
+        // A file still being sealed (or left by an interrupted rotation) precedes the live one.
+        for (const std::string &plain : {activePath + ".sealing", activePath})
+        {
+            std::ifstream live(plain);
+            std::string line;
+            while (getline(live, line))
+            {
+                scanned++;
+                if (!line.empty() && q.matches(line.data(), line.size()))
+                    lines.push_back(line);
+            }
+        }
+        if (linesScanned)
+            *linesScanned = scanned;
+        return lines;
+    }
+};
+
+#endif
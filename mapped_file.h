@@ -0,0 +1,91 @@
+// mapped_file.h - read-only view of a whole file.
+//
+// Uses mmap on POSIX systems so opening a large inventory costs no reads up
+// front; other platforms fall back to reading the file into memory.
+#ifndef MEDINV_MAPPED_FILE_H
+#define MEDINV_MAPPED_FILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+private:
+    const char *ptr = nullptr;
+    size_t len = 0;
+#ifdef _WIN32
+    std::string buffer;
+#else
+    void *mapping = nullptr;
+#endif
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(); }
+
+    // Returns false if the file cannot be opened. An empty file maps to size() == 0.
+    bool open(const std::string &filename)
+    {
+        close();
+#ifdef _WIN32
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            return false;
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        ptr = buffer.data();
+        len = buffer.size();
+        return true;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0)
+        {
+            mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                mapping = nullptr;
+                ok = false;
+            }
+            else
+            {
+                ptr = static_cast<const char *>(mapping);
+                len = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (mapping)
+            munmap(mapping, len);
+        mapping = nullptr;
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const char *data() const { return ptr; }
+    size_t size() const { return len; }
+};
+
+#endif
@@ -0,0 +1,427 @@
+// medicine_schema.h - one field list for Medicine, expanded at compile time into
+// every record format the project uses:
+//
+//   InventoryTextFormat  inventory.txt rows: name,batch,YYYY-MM-DD,qty,price,original
+//   BackupCsvFormat      app.py's backup download: header row, RFC 4180 quoting
+//   BinaryCodec          length-prefixed strings and little-endian numbers
+//   Table                the console table used by display()/displayInventory()
+//
+// Each field is an empty type carrying a member pointer and a Kind, so the
+// codecs are folds over a type list: every field's parse/format call is chosen
+// by `if constexpr`, with no per-field switch or virtual call at run time.
+// A record class opts in with `template <typename> friend struct MedicineSchema;`.
+#ifndef MEDINV_MEDICINE_SCHEMA_H
+#define MEDINV_MEDICINE_SCHEMA_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "money.h"
+
+namespace schema
+{
+    enum class Kind
+    {
+        Text,
+        Date, // stored as "YYYY-MM-DD" in the record
+        Int,
+        Price // money::Paise, written as decimal rupees
+    };
+
+    struct InventoryTextFormat
+    {
+        static constexpr char SEP = ',';
+        static constexpr bool QUOTED = false;
+    };
+
+    // What Python's csv module writes and reads by default: fields holding the
+    // separator, a quote or a line break are quoted, with quotes doubled.
+    struct BackupCsvFormat
+    {
+        static constexpr char SEP = ',';
+        static constexpr bool QUOTED = true;
+    };
+
+    template <typename Tuple, typename Fn, size_t... I>
+    inline void forEachImpl(Fn &fn, std::index_sequence<I...>)
+    {
+        (fn(std::tuple_element_t<I, Tuple>{}, std::integral_constant<size_t, I>{}), ...);
+    }
+
+    // Calls fn(Field{}, index) for every field type in the tuple, unrolled at compile time.
+    template <typename Tuple, typename Fn>
+    inline void forEachField(Fn &&fn)
+    {
+        forEachImpl<Tuple>(fn, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+    }
+
+    template <typename Format>
+    inline void appendText(std::string &out, const std::string &value)
+    {
+        if constexpr (Format::QUOTED)
+        {
+            if (value.find_first_of(std::string{Format::SEP, '"', '\r', '\n'}) != std::string::npos)
+            {
+                out += '"';
+                for (char c : value)
+                {
+                    if (c == '"')
+                        out += '"';
+                    out += c;
+                }
+                out += '"';
+                return;
+            }
+        }
+        out += value;
+    }
+
+    // Locates the field starting at p: [fb, fe) receives its text, unescaped
+    // into scratch if it was quoted. Returns where the field ends, at a
+    // separator or at e. Line breaks inside quotes are not supported, since
+    // records are split into lines first.
+    template <typename Format>
+    inline const char *nextField(const char *p, const char *e, std::string &scratch, const char *&fb, const char *&fe)
+    {
+        if constexpr (Format::QUOTED)
+        {
+            if (p < e && *p == '"')
+            {
+                scratch.clear();
+                for (p++; p < e; p++)
+                {
+                    if (*p != '"')
+                        scratch += *p;
+                    else if (p + 1 < e && p[1] == '"')
+                        scratch += *p++;
+                    else
+                    {
+                        p++;
+                        break;
+                    }
+                }
+                fb = scratch.data();
+                fe = fb + scratch.size();
+                const char *end = static_cast<const char *>(std::memchr(p, Format::SEP, (size_t)(e - p)));
+                return end ? end : e;
+            }
+        }
+        const char *end = static_cast<const char *>(std::memchr(p, Format::SEP, (size_t)(e - p)));
+        fb = p;
+        fe = end ? end : e;
+        return fe;
+    }
+
+    inline void trim(const char *&b, const char *&e)
+    {
+        while (b < e && (*b == ' ' || *b == '\t'))
+            b++;
+        while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+            e--;
+    }
+
+    // Unparseable numbers read as 0, matching the old stringstream loader's fallback.
+    // So do negative prices, which addMedicine would have refused. Returns false
+    // when it had to fall back.
+    template <Kind K, typename Format, typename T>
+    inline bool parseField(const char *b, const char *e, T &value)
+    {
+        if constexpr (K == Kind::Text || K == Kind::Date)
+        {
+            value.assign(b, e);
+            return true;
+        }
+        else if constexpr (K == Kind::Price)
+        {
+            trim(b, e);
+            if (money::parse(b, e, value) && value >= 0)
+                return true;
+            value = 0;
+            return false;
+        }
+        else
+        {
+            trim(b, e);
+            if (b < e && *b == '+')
+                b++;
+            value = T();
+            if (std::from_chars(b, e, value).ec == std::errc())
+                return true;
+            value = T();
+            return false;
+        }
+    }
+
+    template <Kind K, typename Format, typename T>
+    inline void writeField(std::string &out, const T &value)
+    {
+        if constexpr (K == Kind::Text || K == Kind::Date)
+            appendText<Format>(out, value);
+        else if constexpr (K == Kind::Price)
+            money::append(out, value);
+        else
+        {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+    }
+
+    // Delimited text codec for Schema in Format: one record per line, no trailing newline.
+    template <typename Schema, typename Format>
+    struct TextCodec
+    {
+        using Record = typename Schema::Record;
+        using Fields = typename Schema::Fields;
+
+        static void writeHeader(std::string &out)
+        {
+            forEachField<Fields>([&](auto field, auto index)
+            {
+                if (index > 0)
+                    out += Format::SEP;
+                out += decltype(field)::CSV_LABEL;
+            });
+        }
+
+        static void write(std::string &out, const Record &r)
+        {
+            forEachField<Fields>([&](auto field, auto index)
+            {
+                using F = decltype(field);
+                if (index > 0)
+                    out += Format::SEP;
+                writeField<F::KIND, Format>(out, r.*F::MEMBER);
+            });
+        }
+
+        // Parses the line [b, e). Missing or empty fields are left for Schema::fillDefaults.
+        // Returns a mask (bit i for field i) of fields that were missing, empty or invalid.
+        static uint32_t parse(const char *b, const char *e, Record &r)
+        {
+            const char *p = b;
+            bool more = true;
+            uint32_t missing = 0, invalid = 0;
+            std::string scratch;
+            forEachField<Fields>([&](auto field, auto index)
+            {
+                using F = decltype(field);
+                const char *fb = p, *fe = p;
+                if (more)
+                {
+                    const char *end = nextField<Format>(p, e, scratch, fb, fe);
+                    more = end < e;
+                    p = more ? end + 1 : e;
+                }
+                if (fb == fe)
+                    missing |= 1u << index;
+                if (!parseField<F::KIND, Format>(fb, fe, r.*F::MEMBER))
+                    invalid |= 1u << index;
+            });
+            Schema::fillDefaults(r, missing);
+            return missing | invalid;
+        }
+    };
+
+    // Binary codec: u16 length + bytes for text, little-endian numbers at their own width.
+    template <typename Schema>
+    struct BinaryCodec
+    {
+        using Record = typename Schema::Record;
+        using Fields = typename Schema::Fields;
+
+        static void put(std::string &out, uint64_t v, int bytes)
+        {
+            for (int i = 0; i < bytes; i++)
+                out.push_back((char)(v >> (8 * i)));
+        }
+
+        static uint64_t get(const char *p, int bytes)
+        {
+            uint64_t v = 0;
+            for (int i = 0; i < bytes; i++)
+                v |= (uint64_t)(unsigned char)p[i] << (8 * i);
+            return v;
+        }
+
+        static void write(std::string &out, const Record &r)
+        {
+            forEachField<Fields>([&](auto field, auto)
+            {
+                using F = decltype(field);
+                const auto &value = r.*F::MEMBER;
+                if constexpr (F::KIND == Kind::Text || F::KIND == Kind::Date)
+                {
+                    size_t n = std::min<size_t>(value.size(), 0xFFFF);
+                    put(out, (uint32_t)n, 2);
+                    out.append(value.data(), n);
+                }
+                else
+                {
+                    constexpr int BYTES = sizeof(value);
+                    static_assert(BYTES == 4 || BYTES == 8, "binary numbers are 32- or 64-bit");
+                    std::conditional_t<BYTES == 4, uint32_t, uint64_t> bits;
+                    std::memcpy(&bits, &value, BYTES);
+                    put(out, bits, BYTES);
+                }
+            });
+        }
+
+        // Reads one record at p and advances p; returns false on truncated input.
+        static bool parse(const char *&p, const char *end, Record &r)
+        {
+            bool ok = true;
+            forEachField<Fields>([&](auto field, auto)
+            {
+                using F = decltype(field);
+                auto &value = r.*F::MEMBER;
+                if (!ok)
+                    return;
+                if constexpr (F::KIND == Kind::Text || F::KIND == Kind::Date)
+                {
+                    size_t n = end - p >= 2 ? get(p, 2) : 0;
+                    if (end - p < 2 || (size_t)(end - p - 2) < n)
+                    {
+                        ok = false;
+                        return;
+                    }
+                    value.assign(p + 2, n);
+                    p += 2 + n;
+                }
+                else
+                {
+                    constexpr int BYTES = sizeof(value);
+                    if (end - p < BYTES)
+                    {
+                        ok = false;
+                        return;
+                    }
+                    auto bits = (std::conditional_t<BYTES == 4, uint32_t, uint64_t>)get(p, BYTES);
+                    std::memcpy(&value, &bits, BYTES);
+                    p += BYTES;
+                }
+            });
+            return ok;
+        }
+    };
+
+    // Fixed-width console table; column widths and titles come from the schema.
+    template <typename Schema>
+    struct Table
+    {
+        using Record = typename Schema::Record;
+        using Fields = typename Schema::Fields;
+
+        static void header(std::ostream &out)
+        {
+            int total = 0;
+            out << std::left;
+            forEachField<Fields>([&](auto field, auto)
+            {
+                using F = decltype(field);
+                out << std::setw(F::WIDTH) << F::LABEL;
+                total += F::WIDTH;
+            });
+            out << "\n"
+                << std::string(total, '-') << "\n";
+        }
+
+        static void row(std::ostream &out, const Record &r)
+        {
+            out << std::left;
+            forEachField<Fields>([&](auto field, auto)
+            {
+                using F = decltype(field);
+                if constexpr (F::KIND == Kind::Price)
+                    out << std::setw(F::WIDTH) << money::format(r.*F::MEMBER);
+                else
+                    out << std::setw(F::WIDTH) << r.*F::MEMBER;
+            });
+            out << "\n";
+        }
+    };
+}
+
+// Field list for any class with Medicine's data members.
+template <typename M>
+struct MedicineSchema
+{
+    using Record = M;
+
+    struct Name
+    {
+        static constexpr auto MEMBER = &M::name;
+        static constexpr schema::Kind KIND = schema::Kind::Text;
+        static constexpr const char *LABEL = "Name";
+        static constexpr const char *CSV_LABEL = "Medicine Name";
+        static constexpr int WIDTH = 15;
+    };
+    struct Batch
+    {
+        static constexpr auto MEMBER = &M::batchNumber;
+        static constexpr schema::Kind KIND = schema::Kind::Text;
+        static constexpr const char *LABEL = "Batch";
+        static constexpr const char *CSV_LABEL = "Batch Number";
+        static constexpr int WIDTH = 12;
+    };
+    struct Expiry
+    {
+        static constexpr auto MEMBER = &M::expiryDate;
+        static constexpr schema::Kind KIND = schema::Kind::Date;
+        static constexpr const char *LABEL = "Expiry";
+        static constexpr const char *CSV_LABEL = "Expiry Date";
+        static constexpr int WIDTH = 15;
+    };
+    struct Quantity
+    {
+        static constexpr auto MEMBER = &M::quantity;
+        static constexpr schema::Kind KIND = schema::Kind::Int;
+        static constexpr const char *LABEL = "QtyLeft";
+        static constexpr const char *CSV_LABEL = "Quantity";
+        static constexpr int WIDTH = 10;
+    };
+    struct Price
+    {
+        static constexpr auto MEMBER = &M::price;
+        static constexpr schema::Kind KIND = schema::Kind::Price;
+        static constexpr const char *LABEL = "Price/Unit";
+        static constexpr const char *CSV_LABEL = "Price";
+        static constexpr int WIDTH = 12;
+    };
+    struct Original
+    {
+        static constexpr auto MEMBER = &M::originalQuantity;
+        static constexpr schema::Kind KIND = schema::Kind::Int;
+        static constexpr const char *LABEL = "OriginalQty";
+        static constexpr const char *CSV_LABEL = "Original Quantity";
+        static constexpr int WIDTH = 15;
+    };
+
+    using Fields = std::tuple<Name, Batch, Expiry, Quantity, Price, Original>;
+
+    // Bits of the mask TextCodec::parse returns, by position in Fields.
+    static constexpr uint32_t PRICE_BIT = 1u << 4;
+    static constexpr uint32_t ORIGINAL_BIT = 1u << 5;
+
+    // Rows written before originalQuantity existed start out "full".
+    static void fillDefaults(M &m, uint32_t missing)
+    {
+        if (missing & ORIGINAL_BIT)
+            m.originalQuantity = m.quantity;
+    }
+
+    using InventoryText = schema::TextCodec<MedicineSchema, schema::InventoryTextFormat>;
+    using BackupCsv = schema::TextCodec<MedicineSchema, schema::BackupCsvFormat>;
+    using Binary = schema::BinaryCodec<MedicineSchema>;
+    using Table = schema::Table<MedicineSchema>;
+};
+
+#endif
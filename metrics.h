@@ -0,0 +1,270 @@
+// metrics.h - low-overhead counters and latency histograms for InventoryManager.
+//
+// Each thread records into its own shard, so the hot path is a couple of
+// uncontended relaxed stores and no locks. Shards are merged only when the
+// metrics are dumped in Prometheus text format. Set MEDINV_METRICS=0 in the
+// environment (or call metrics::setEnabled(false)) to turn recording off.
+#ifndef MEDINV_METRICS_H
+#define MEDINV_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace metrics
+{
+    enum Op
+    {
+        OP_LOAD,
+        OP_SAVE,
+        OP_WRITE_HISTORY,
+        OP_LOOKUP,
+        OP_SELL,
+        OP_REPORT_LOW_STOCK,
+        OP_REPORT_EXPIRED,
+        OP_REPORT_INVENTORY,
+        OP_SCAN_HISTORY,
+        OP_RECEIVE,
+        OP_COUNT
+    };
+
+    enum Counter
+    {
+        ROWS_SCANNED,
+        BYTES_WRITTEN,
+        FILES_CLOSED, // files flushed and closed after a write (no fsync(2) is issued)
+        COUNTER_COUNT
+    };
+
+    inline const char *opName(int op)
+    {
+        static const char *names[OP_COUNT] = {
+            "load", "save", "write_history", "lookup", "sell",
+            "report_low_stock", "report_expired", "report_inventory", "scan_history",
+            "receive"};
+        return names[op];
+    }
+
+    // HDR-style log-linear buckets: values below 16 get a bucket each, every
+    // power of two above that is split into 16 sub-buckets, so any recorded
+    // latency is off by at most 1/16 (6.25%) of its value.
+    const int SUB_BUCKET_BITS = 4;
+    const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    const int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    inline int bucketFor(uint64_t v)
+    {
+        if (v < (uint64_t)SUB_BUCKETS)
+            return (int)v;
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + (int)((v >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // Largest value that maps to bucket b.
+    inline uint64_t bucketUpperBound(int b)
+    {
+        if (b < SUB_BUCKETS)
+            return (uint64_t)b;
+        int shift = b / SUB_BUCKETS - 1;
+        uint64_t base = (uint64_t)(SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+        return base + ((uint64_t)1 << shift) - 1;
+    }
+
+    // Written only by its owning thread; read by the dumper. Relaxed atomics
+    // keep that race well-defined without costing a locked instruction.
+    struct Shard
+    {
+        std::atomic<uint64_t> buckets[OP_COUNT][BUCKETS];
+        std::atomic<uint64_t> count[OP_COUNT];
+        std::atomic<uint64_t> sumNs[OP_COUNT];
+        std::atomic<uint64_t> counters[OP_COUNT][COUNTER_COUNT];
+
+        Shard()
+        {
+            for (int op = 0; op < OP_COUNT; op++)
+            {
+                for (int b = 0; b < BUCKETS; b++)
+                    buckets[op][b].store(0, std::memory_order_relaxed);
+                count[op].store(0, std::memory_order_relaxed);
+                sumNs[op].store(0, std::memory_order_relaxed);
+                for (int c = 0; c < COUNTER_COUNT; c++)
+                    counters[op][c].store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    inline void bump(std::atomic<uint64_t> &cell, uint64_t n)
+    {
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    class Registry
+    {
+    private:
+        std::mutex mtx;
+        std::vector<std::unique_ptr<Shard>> shards; // never freed: threads may exit before a dump
+        std::map<std::string, double> gauges;
+
+    public:
+        std::atomic<bool> enabled;
+
+        Registry()
+        {
+            const char *env = std::getenv("MEDINV_METRICS");
+            enabled.store(!(env && std::string(env) == "0"));
+        }
+
+        static Registry &instance()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        Shard *attach()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            shards.emplace_back(new Shard());
+            return shards.back().get();
+        }
+
+        void setGauge(const std::string &name, double value)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            gauges[name] = value;
+        }
+
+        void writePrometheus(std::ostream &out)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            out << std::setprecision(9);
+            static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+            static const char *QUANTILE_LABELS[] = {"0.5", "0.9", "0.99", "0.999"};
+
+            std::vector<uint64_t> merged(BUCKETS);
+            out << "# HELP medinv_op_duration_seconds Latency of inventory operations.\n"
+                << "# TYPE medinv_op_duration_seconds summary\n";
+            for (int op = 0; op < OP_COUNT; op++)
+            {
+                uint64_t count = 0, sum = 0;
+                std::fill(merged.begin(), merged.end(), 0);
+                for (auto &s : shards)
+                {
+                    count += s->count[op].load(std::memory_order_relaxed);
+                    sum += s->sumNs[op].load(std::memory_order_relaxed);
+                    for (int b = 0; b < BUCKETS; b++)
+                        merged[b] += s->buckets[op][b].load(std::memory_order_relaxed);
+                }
+                for (int qi = 0; qi < 4; qi++)
+                {
+                    uint64_t rank = (uint64_t)(QUANTILES[qi] * count), seen = 0;
+                    uint64_t value = 0;
+                    for (int b = 0; b < BUCKETS && count > 0; b++)
+                    {
+                        seen += merged[b];
+                        if (seen > rank)
+                        {
+                            value = bucketUpperBound(b);
+                            break;
+                        }
+                    }
+                    out << "medinv_op_duration_seconds{op=\"" << opName(op) << "\",quantile=\"" << QUANTILE_LABELS[qi]
+                        << "\"} " << value * 1e-9 << "\n";
+                }
+                out << "medinv_op_duration_seconds_sum{op=\"" << opName(op) << "\"} " << sum * 1e-9 << "\n"
+                    << "medinv_op_duration_seconds_count{op=\"" << opName(op) << "\"} " << count << "\n";
+            }
+
+            static const char *COUNTER_NAMES[COUNTER_COUNT] = {
+                "medinv_rows_scanned_total", "medinv_bytes_written_total", "medinv_files_closed_total"};
+            for (int c = 0; c < COUNTER_COUNT; c++)
+            {
+                out << "# TYPE " << COUNTER_NAMES[c] << " counter\n";
+                for (int op = 0; op < OP_COUNT; op++)
+                {
+                    uint64_t total = 0;
+                    for (auto &s : shards)
+                        total += s->counters[op][c].load(std::memory_order_relaxed);
+                    if (total > 0)
+                        out << COUNTER_NAMES[c] << "{op=\"" << opName(op) << "\"} " << total << "\n";
+                }
+            }
+
+            for (auto &g : gauges)
+                out << "# TYPE " << g.first << " gauge\n"
+                    << g.first << " " << g.second << "\n";
+        }
+    };
+
+    inline bool enabled() { return Registry::instance().enabled.load(std::memory_order_relaxed); }
+    inline void setEnabled(bool on) { Registry::instance().enabled.store(on); }
+
+    inline Shard &local()
+    {
+        thread_local Shard *shard = Registry::instance().attach();
+        return *shard;
+    }
+
+    inline void add(Op op, Counter c, uint64_t n)
+    {
+        if (enabled())
+            bump(local().counters[op][c], n);
+    }
+
+    inline void record(Op op, uint64_t ns)
+    {
+        Shard &s = local();
+        bump(s.buckets[op][bucketFor(ns)], 1);
+        bump(s.count[op], 1);
+        bump(s.sumNs[op], ns);
+    }
+
+    inline void setGauge(const std::string &name, double value) { Registry::instance().setGauge(name, value); }
+
+    inline void writePrometheus(std::ostream &out) { Registry::instance().writePrometheus(out); }
+
+    inline bool dumpToFile(const std::string &filename)
+    {
+        std::ofstream out(filename);
+        if (!out)
+            return false;
+        writePrometheus(out);
+        return true;
+    }
+
+    // Times the enclosing scope as one operation.
+    class ScopedTimer
+    {
+    private:
+        Op op;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedTimer(Op o) : op(o), active(enabled())
+        {
+            if (active)
+                start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer()
+        {
+            if (active)
+                record(op, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,103 @@
+// money.h - exact currency amounts as integer paise (100 paise = 1 rupee).
+//
+// Prices used to be floats, so totals on large quantities drifted and the
+// history log recorded values like "total=12750000.000000". Amounts are now
+// whole paise in an int64_t: parsing, formatting and arithmetic are exact, and
+// rounding happens only where an explicit rate (basis points) is applied.
+#ifndef MEDINV_MONEY_H
+#define MEDINV_MONEY_H
+
+#include <cstdint>
+#include <string>
+
+namespace money
+{
+    typedef int64_t Paise;
+
+    const Paise PAISE_PER_RUPEE = 100;
+
+    // Rates are in basis points: 1 bp = 0.01%, so 18% GST is 1800.
+    const int64_t BP_SCALE = 10000;
+
+    // Parses a decimal rupee amount ("12", "8.5", "2.000000", "-3.25", ".75") into
+    // paise. Digits past the second decimal place round half away from zero.
+    // Returns false, leaving out untouched, for anything else or on overflow.
+    inline bool parse(const char *b, const char *e, Paise &out)
+    {
+        bool negative = false;
+        if (b < e && (*b == '-' || *b == '+'))
+            negative = *b++ == '-';
+        Paise whole = 0;
+        int digits = 0;
+        for (; b < e && *b >= '0' && *b <= '9'; b++, digits++)
+        {
+            if (whole > (INT64_MAX / PAISE_PER_RUPEE - 10) / 10)
+                return false;
+            whole = whole * 10 + (*b - '0');
+        }
+        Paise fraction = 0;
+        if (b < e && *b == '.')
+        {
+            b++;
+            int places = 0;
+            for (; b < e && *b >= '0' && *b <= '9'; b++, digits++, places++)
+            {
+                if (places < 2)
+                    fraction = fraction * 10 + (*b - '0');
+                else if (places == 2 && *b >= '5')
+                    fraction++; // may carry into the next rupee; the sum below absorbs it
+            }
+            if (places == 1)
+                fraction *= 10;
+        }
+        if (b != e || digits == 0)
+            return false;
+        Paise value = whole * PAISE_PER_RUPEE + fraction;
+        out = negative ? -value : value;
+        return true;
+    }
+
+    inline bool parse(const std::string &text, Paise &out) { return parse(text.data(), text.data() + text.size(), out); }
+
+    // Shortest exact text, for data files: 500 -> "5", 850 -> "8.5", 855 -> "8.55".
+    inline void append(std::string &out, Paise p)
+    {
+        uint64_t magnitude = p < 0 ? 0 - (uint64_t)p : (uint64_t)p;
+        if (p < 0)
+            out += '-';
+        out += std::to_string(magnitude / PAISE_PER_RUPEE);
+        unsigned cents = (unsigned)(magnitude % PAISE_PER_RUPEE);
+        if (cents != 0)
+        {
+            out += '.';
+            out += (char)('0' + cents / 10);
+            if (cents % 10 != 0)
+                out += (char)('0' + cents % 10);
+        }
+    }
+
+    // Fixed two decimals, for bills and the history log: 850 -> "8.50".
+    inline std::string format(Paise p)
+    {
+        uint64_t magnitude = p < 0 ? 0 - (uint64_t)p : (uint64_t)p;
+        std::string out = p < 0 ? "-" : "";
+        out += std::to_string(magnitude / PAISE_PER_RUPEE);
+        unsigned cents = (unsigned)(magnitude % PAISE_PER_RUPEE);
+        out += '.';
+        out += (char)('0' + cents / 10);
+        out += (char)('0' + cents % 10);
+        return out;
+    }
+
+    // amount * bp / 10000 rounded half up, for amount >= 0 and 0 <= bp <= 10000.
+    // Splitting amount at BP_SCALE keeps every intermediate below amount + 10^8,
+    // so this cannot overflow where the plain product amount * bp would.
+    inline Paise applyBasisPoints(Paise amount, int64_t bp)
+    {
+        // Unsigned division by a constant is a multiply and shift, with no sign fix-up.
+        uint64_t a = (uint64_t)amount, r = (uint64_t)bp, scale = (uint64_t)BP_SCALE;
+        return (Paise)(a / scale * r + (a % scale * r + scale / 2) / scale);
+    }
+}
+
+#endif
@@ -4,11 +4,13 @@
 #include <string>
 #include <ctime>
 #include <iomanip>
-#include <sstream>
 #include <tuple>
 #include <cstdio>
 #include <limits>
 
+#include "medicine_schema.h"
+#include "money.h"
+
 /*Changes to be Made:
 1)GUI
 2)
@@ -31,25 +33,28 @@ public:
 class Medicine : public Record
 {
 private:
+    template <typename>
+    friend struct MedicineSchema;
+
     std::string name;
     std::string batchNumber;
     std::string expiryDate;
     int quantity;
-    float price;
+    money::Paise price; // per unit
     int originalQuantity;
 
 public:
-    Medicine() : quantity(0), price(0.0f), originalQuantity(0) {}
+    Medicine() : quantity(0), price(0), originalQuantity(0) {}
 
     Medicine(const std::string &n, const std::string &b, const std::string &e,
-             int q, float p)
+             int q, money::Paise p)
         : name(n), batchNumber(b), expiryDate(e), quantity(q), price(p), originalQuantity(q) {}
 
     std::string getName() const { return name; }
     std::string getBatchNumber() const { return batchNumber; }
     std::string getExpiryDate() const { return expiryDate; }
     int getQuantity() const { return quantity; }
-    float getPrice() const { return price; }
+    money::Paise getPrice() const { return price; }
     int getOriginalQuantity() const { return originalQuantity; }
 
     void setQuantity(int q) { quantity = q; }
@@ -57,18 +62,15 @@ public:
 
     void display() const override
     {
-        std::cout << std::left << std::setw(15) << name
-                  << std::setw(12) << batchNumber
-                  << std::setw(15) << expiryDate
-                  << std::setw(8) << quantity
-                  << std::setw(8) << price
-                  << std::setw(10) << originalQuantity << "\n";
+        MedicineSchema<Medicine>::Table::row(std::cout, *this);
     }
 
     void saveToFile(std::ofstream &out) const override
     {
-        out << name << "," << batchNumber << "," << expiryDate << ","
-            << quantity << "," << price << "," << originalQuantity << "\n";
+        std::string line;
+        MedicineSchema<Medicine>::InventoryText::write(line, *this);
+        line += '\n';
+        out << line;
     }
 
     // Convert "YYYY-MM-DD" -> time_t. Returns -1 on parse error.
@@ -99,31 +101,8 @@ public:
 
     static Medicine loadFromFile(const std::string &line)
     {
-        std::stringstream ss(line);
-        std::string n, b, e, qStr, pStr, oqStr;
-        getline(ss, n, ',');
-        getline(ss, b, ',');
-        getline(ss, e, ',');
-        getline(ss, qStr, ',');
-        getline(ss, pStr, ',');
-        getline(ss, oqStr, ',');
-        int q = 0;
-        float p = 0.0f;
-        try
-        {
-            if (!qStr.empty())
-                q = std::stoi(qStr);
-            if (!pStr.empty())
-                p = std::stof(pStr);
-        }
-        catch (...)
-        {
-            q = 0;
-            p = 0.0f;
-        }
-        int oq = oqStr.empty() ? q : std::stoi(oqStr);
-        Medicine med(n, b, e, q, p);
-        med.originalQuantity = oq;
+        Medicine med;
+        MedicineSchema<Medicine>::InventoryText::parse(line.data(), line.data() + line.size(), med);
         return med;
     }
 
@@ -178,7 +157,7 @@ public:
     {
         std::string name, batch, expiry;
         int quantity;
-        float price;
+        std::string priceText;
 
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         std::cout << "Enter medicine name: ";
@@ -190,7 +169,14 @@ public:
         std::cout << "Enter original quantity: ";
         std::cin >> quantity;
         std::cout << "Enter price per unit: ";
-        std::cin >> price;
+        std::cin >> priceText;
+
+        money::Paise price;
+        if (!money::parse(priceText, price) || price < 0)
+        {
+            std::cout << "Invalid price.\n";
+            return;
+        }
 
         inventory.push_back(Medicine(name, batch, expiry, quantity, price));
         std::cout << "Medicine added successfully!\n";
@@ -266,13 +252,7 @@ public:
     void displayInventory() const
     {
         std::cout << "\n=== INVENTORY LIST ===\n";
-        std::cout << std::left << std::setw(15) << "Name"
-                  << std::setw(12) << "Batch"
-                  << std::setw(15) << "Expiry"
-                  << std::setw(8) << "Qty"
-                  << std::setw(8) << "Price"
-                  << std::setw(10) << "Original" << "\n";
-        std::cout << "----------------------------------------------------------------\n";
+        MedicineSchema<Medicine>::Table::header(std::cout);
         for (const Medicine &med : inventory)
         {
             med.display();
@@ -282,9 +262,9 @@ public:
     // Multi-purchase billing system
     void buyMedicines()
     {
-        std::vector<std::tuple<std::string, int, float>> billItems;
+        std::vector<std::tuple<std::string, int, money::Paise>> billItems;
         char choice;
-        float total = 0.0f;
+        money::Paise total = 0;
 
         do
         {
@@ -302,7 +282,7 @@ public:
                     std::cin >> qty;
                     if (med.sell(qty))
                     {
-                        float cost = qty * med.getPrice();
+                        money::Paise cost = (money::Paise)qty * med.getPrice();
                         total += cost;
                         billItems.push_back({med.getName(), qty, cost});
                         std::cout << "Added to bill: " << med.getName() << " x" << qty << "\n";
@@ -333,10 +313,10 @@ public:
             {
                 std::cout << std::setw(15) << std::get<0>(item)
                           << std::setw(8) << std::get<1>(item)
-                          << std::setw(10) << std::get<2>(item) << "\n";
+                          << std::setw(10) << money::format(std::get<2>(item)) << "\n";
             }
             std::cout << "----------------------------------\n";
-            std::cout << "TOTAL: " << total << "\n";
+            std::cout << "TOTAL: " << money::format(total) << "\n";
             std::cout << "=======================\n";
         }
         else
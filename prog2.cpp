@@ -7,6 +7,19 @@
 #include <sstream>
 #include <tuple>
 #include <limits>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#include "billing.h"
+#include "history_archive.h"
+#include "mapped_file.h"
+#include "medicine_schema.h"
+#include "metrics.h"
 
 // ===============================
 // Medicine Class
@@ -18,21 +31,24 @@ private:
     std::string batchNumber;
     std::string expiryDate;
     int quantity;
-    float price;
+    money::Paise price; // per unit
     int originalQuantity;
 
+    template <typename>
+    friend struct MedicineSchema;
+
 public:
-    Medicine() : quantity(0), price(0.0f), originalQuantity(0) {}
+    Medicine() : quantity(0), price(0), originalQuantity(0) {}
 
     Medicine(const std::string &n, const std::string &b, const std::string &e,
-             int q, float p)
+             int q, money::Paise p)
         : name(n), batchNumber(b), expiryDate(e), quantity(q), price(p), originalQuantity(q) {}
 
     std::string getName() const { return name; }
     std::string getBatchNumber() const { return batchNumber; }
     std::string getExpiryDate() const { return expiryDate; }
     int getQuantity() const { return quantity; }
-    float getPrice() const { return price; }
+    money::Paise getPrice() const { return price; }
     int getOriginalQuantity() const { return originalQuantity; }
 
     void setQuantity(int q) { quantity = q; }
@@ -40,38 +56,61 @@ public:
 
     void display() const
     {
-        std::cout << std::left << std::setw(15) << name
-                  << std::setw(12) << batchNumber
-                  << std::setw(15) << expiryDate
-                  << std::setw(10) << quantity
-                  << std::setw(12) << price
-                  << std::setw(15) << originalQuantity << "\n";
+        MedicineSchema<Medicine>::Table::row(std::cout, *this);
+    }
+
+    // Appends this record as one inventory.txt row, newline included.
+    void appendTo(std::string &out) const
+    {
+        MedicineSchema<Medicine>::InventoryText::write(out, *this);
+        out += '\n';
     }
 
     void saveToFile(std::ofstream &out) const
     {
-        out << name << "," << batchNumber << "," << expiryDate << ","
-            << quantity << "," << price << "," << originalQuantity << "\n";
+        std::string line;
+        appendTo(line);
+        out << line;
     }
 
-    static Medicine loadFromFile(const std::string &line)
+    // Parses one inventory.txt row held in [b, e), without its newline.
+    static Medicine parse(const char *b, const char *e)
     {
-        std::stringstream ss(line);
-        std::string n, b, e, qStr, pStr, oqStr;
-        getline(ss, n, ',');
-        getline(ss, b, ',');
-        getline(ss, e, ',');
-        getline(ss, qStr, ',');
-        getline(ss, pStr, ',');
-        getline(ss, oqStr, ',');
-        int q = qStr.empty() ? 0 : std::stoi(qStr);
-        float p = pStr.empty() ? 0.0f : std::stof(pStr);
-        int oq = oqStr.empty() ? q : std::stoi(oqStr);
-        Medicine med(n, b, e, q, p);
-        med.originalQuantity = oq;
+        Medicine med;
+        MedicineSchema<Medicine>::InventoryText::parse(b, e, med);
         return med;
     }
 
+    // As above; invalid receives the MedicineSchema mask of missing or unparseable fields.
+    static Medicine parse(const char *b, const char *e, uint32_t &invalid)
+    {
+        Medicine med;
+        invalid = MedicineSchema<Medicine>::InventoryText::parse(b, e, med);
+        return med;
+    }
+
+    static Medicine loadFromFile(const std::string &line)
+    {
+        return parse(line.data(), line.data() + line.size());
+    }
+
+    // True for a real calendar date written as "YYYY-MM-DD".
+    static bool isValidDate(const std::string &d)
+    {
+        if (d.size() != 10 || d[4] != '-' || d[7] != '-')
+            return false;
+        for (int i : {0, 1, 2, 3, 5, 6, 8, 9})
+            if (d[i] < '0' || d[i] > '9')
+                return false;
+        auto num = [&](int at, int len) { return std::stoi(d.substr(at, len)); };
+        int y = num(0, 4), m = num(5, 2), day = num(8, 2);
+        static const int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (m < 1 || m > 12 || day < 1)
+            return false;
+        bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+        return day <= DAYS[m - 1] + (m == 2 && leap);
+    }
+
     // Convert "YYYY-MM-DD" -> time_t
     time_t convertToTime(const std::string &dateStr) const
     {
@@ -95,6 +134,20 @@ public:
         return difftime(exp, now) < 0;
     }
 
+    // Books a delivery of qty units; a non-empty expiry replaces the current one.
+    // Returns false, changing nothing, if either count would exceed INT_MAX.
+    bool receive(int qty, const std::string &e)
+    {
+        const long long LIMIT = std::numeric_limits<int>::max();
+        if ((long long)quantity + qty > LIMIT || (long long)originalQuantity + qty > LIMIT)
+            return false;
+        quantity += qty;
+        originalQuantity += qty;
+        if (!e.empty())
+            expiryDate = e;
+        return true;
+    }
+
     bool sell(int qty)
     {
         if (qty <= 0 || qty > quantity)
@@ -107,12 +160,162 @@ public:
 // ===============================
 // InventoryManager Class
 // ===============================
+// Calls fn(begin, end) for each non-empty line of [data, data + size), without
+// its line ending, until fn returns false.
+template <typename Fn>
+void forEachLine(const char *data, size_t size, Fn fn)
+{
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end)
+    {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!eol)
+            eol = end;
+        const char *last = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+        if (last > p && !fn(p, last))
+            return;
+        p = eol + 1;
+    }
+}
+
+// Replaces filename with data by writing a temporary file and renaming it over
+// the original. Truncating in place would let a process that still has the old
+// file mapped (a lazy start, or a load racing app.py) fault on pages past the
+// new end; after a rename it keeps reading the complete old copy.
+bool replaceFile(const std::string &filename, const std::string &data)
+{
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), (std::streamsize)data.size());
+        out.close();
+        if (!out)
+        {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str()); // rename() does not replace an existing file here
+#endif
+    if (std::rename(temp.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Snapshot opened by InventoryManager::openLazy(). Sales are served from the
+// mapped file while a background thread parses it into the full vector and
+// batch index; records sold from in the meantime live in `touched` and are
+// merged over the built vector at switch-over.
+struct LazySnapshot
+{
+    MappedFile file;
+    std::thread builder;
+    std::atomic<bool> built{false};
+    std::vector<Medicine> records;
+    std::unordered_map<std::string, size_t> index;
+    std::unordered_map<std::string, Medicine> touched;
+
+    ~LazySnapshot()
+    {
+        if (builder.joinable())
+            builder.join();
+    }
+
+    void build()
+    {
+        auto start = std::chrono::steady_clock::now();
+        forEachLine(file.data(), file.size(), [this](const char *b, const char *e)
+        {
+            records.push_back(Medicine::parse(b, e));
+            index.emplace(records.back().getBatchNumber(), records.size() - 1);
+            return true;
+        });
+        metrics::setGauge("medinv_index_build_seconds",
+                          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        built.store(true, std::memory_order_release);
+    }
+
+    // Point lookup straight from the mapped bytes: compares the second field of each row.
+    Medicine *find(const std::string &batch)
+    {
+        auto hit = touched.find(batch);
+        if (hit != touched.end())
+            return &hit->second;
+        Medicine *found = nullptr;
+        uint64_t rows = 0;
+        forEachLine(file.data(), file.size(), [&](const char *b, const char *e)
+        {
+            rows++;
+            const char *comma = static_cast<const char *>(memchr(b, ',', e - b));
+            if (!comma)
+                return true;
+            const char *field = comma + 1;
+            const char *fieldEnd = static_cast<const char *>(memchr(field, ',', e - field));
+            if (!fieldEnd)
+                fieldEnd = e;
+            if ((size_t)(fieldEnd - field) != batch.size() || memcmp(field, batch.data(), batch.size()) != 0)
+                return true;
+            found = &touched.emplace(batch, Medicine::parse(b, e)).first->second;
+            return false;
+        });
+        metrics::add(metrics::OP_LOOKUP, metrics::ROWS_SCANNED, rows);
+        return found;
+    }
+};
+
+// Outcome of one InventoryManager::receiveManifest call.
+struct ReceiptSummary
+{
+    size_t lines = 0;
+    size_t restocked = 0; // rows merged into a stocked batch
+    size_t added = 0;     // rows that created a new batch
+    size_t rejected = 0;  // no batch number, quantity <= 0, an expiry that is not
+                          // YYYY-MM-DD, a new batch with no name or no valid price,
+                          // or stock that would overflow an int
+    long long units = 0;
+};
+
 class InventoryManager
 {
 private:
     std::vector<Medicine> inventory;
+    std::unordered_map<std::string, size_t> batchIndex; // first row holding each batch
+    std::unique_ptr<LazySnapshot> lazy;
+    HistoryArchive history; // history.txt, sealed into history_archive/ past 4 MiB
+    std::chrono::steady_clock::time_point openedAt = std::chrono::steady_clock::now();
+    bool soldSinceOpen = false;
     const int LOW_STOCK_THRESHOLD = 10;
 
+    void rebuildIndex()
+    {
+        batchIndex.clear();
+        for (size_t i = 0; i < inventory.size(); i++)
+            batchIndex.emplace(inventory[i].getBatchNumber(), i);
+    }
+
+    // Finishes a lazy open: waits for the background build and adopts its results.
+    void ensureLoaded()
+    {
+        if (!lazy)
+            return;
+        if (lazy->builder.joinable())
+            lazy->builder.join();
+        inventory = std::move(lazy->records);
+        batchIndex = std::move(lazy->index);
+        for (auto &t : lazy->touched)
+        {
+            auto it = batchIndex.find(t.first);
+            if (it != batchIndex.end())
+                inventory[it->second] = t.second;
+        }
+        lazy.reset();
+    }
+
     std::string currentTimestamp()
     {
         std::time_t now = std::time(nullptr);
@@ -122,40 +325,278 @@ private:
         return oss.str();
     }
 
+public:
     void writeHistory(const std::string &message)
     {
-        std::ofstream log("history.txt", std::ios::app);
-        log << currentTimestamp() << " " << message << "\n";
+        metrics::ScopedTimer timer(metrics::OP_WRITE_HISTORY);
+        std::string entry = currentTimestamp() + " " + message + "\n";
+        history.append(entry);
+        metrics::add(metrics::OP_WRITE_HISTORY, metrics::BYTES_WRITTEN, entry.size());
+        metrics::add(metrics::OP_WRITE_HISTORY, metrics::FILES_CLOSED, 1);
+    }
+
+    // Returns the batch's record, or nullptr if no such batch is stocked.
+    // Once the inventory is fully loaded, the pointer stays valid until the next
+    // call that adds or removes medicines. While a lazy open is still pending it
+    // points into the snapshot and lasts only until the next InventoryManager
+    // call, since any call may finish the open and free the snapshot; callers
+    // that keep it across calls must call ensureLoaded() first.
+    Medicine *findBatch(const std::string &batch)
+    {
+        metrics::ScopedTimer timer(metrics::OP_LOOKUP);
+        if (lazy)
+        {
+            if (!lazy->built.load(std::memory_order_acquire))
+                return lazy->find(batch);
+            ensureLoaded();
+        }
+        metrics::add(metrics::OP_LOOKUP, metrics::ROWS_SCANNED, 1);
+        auto it = batchIndex.find(batch);
+        return it == batchIndex.end() ? nullptr : &inventory[it->second];
+    }
+
+    // Sells qty units of med as a new line on bill and logs the sale at that
+    // line's billed total, so the history and the printed bill always agree.
+    bool sellBatch(Medicine &med, int qty, billing::Bill &bill)
+    {
+        metrics::ScopedTimer timer(metrics::OP_SELL);
+        if (!billing::Bill::fits(med.getPrice(), qty) || !med.sell(qty))
+            return false;
+        if (!soldSinceOpen)
+        {
+            soldSinceOpen = true;
+            metrics::setGauge("medinv_time_to_first_sale_seconds",
+                              std::chrono::duration<double>(std::chrono::steady_clock::now() - openedAt).count());
+        }
+        bill.addLine(med.getPrice(), qty);
+        writeHistory("Bought " + std::to_string(qty) + " of " + med.getName() +
+                     " (" + med.getBatchNumber() + "), total=" + money::format(bill.lineNet(bill.size() - 1)));
+        return true;
+    }
+
+    size_t size()
+    {
+        ensureLoaded();
+        return inventory.size();
+    }
+
+    // Maps the file and returns at once; lookups and sales are served from the
+    // mapping until a background thread has built the full inventory and index.
+    // Everything else waits for that build. Falls back to an eager load if the
+    // file cannot be mapped.
+    void openLazy(const std::string &filename)
+    {
+        ensureLoaded();
+        openedAt = std::chrono::steady_clock::now();
+        soldSinceOpen = false;
+        std::unique_ptr<LazySnapshot> snap(new LazySnapshot());
+        if (!snap->file.open(filename))
+        {
+            loadFromFile(filename);
+            return;
+        }
+        inventory.clear();
+        batchIndex.clear();
+        LazySnapshot *raw = snap.get();
+        snap->builder = std::thread([raw]() { raw->build(); });
+        lazy = std::move(snap);
     }
 
-public:
     void loadFromFile(const std::string &filename)
     {
+        metrics::ScopedTimer timer(metrics::OP_LOAD);
+        lazy.reset();
+        openedAt = std::chrono::steady_clock::now();
+        soldSinceOpen = false;
         inventory.clear();
-        std::ifstream in(filename);
-        std::string line;
-        while (getline(in, line))
+        MappedFile file;
+        uint64_t rows = 0;
+        if (file.open(filename))
         {
-            if (!line.empty())
+            forEachLine(file.data(), file.size(), [&](const char *b, const char *e)
             {
-                Medicine med = Medicine::loadFromFile(line);
-                inventory.push_back(med);
-            }
+                rows++;
+                inventory.push_back(Medicine::parse(b, e));
+                return true;
+            });
+        }
+        metrics::add(metrics::OP_LOAD, metrics::ROWS_SCANNED, rows);
+        rebuildIndex();
+    }
+
+    // Returns false (after reporting it on cerr) if the file could not be replaced.
+    bool saveToFile(const std::string &filename)
+    {
+        ensureLoaded();
+        metrics::ScopedTimer timer(metrics::OP_SAVE);
+        std::string buffer;
+        buffer.reserve(inventory.size() * 64);
+        for (const Medicine &med : inventory)
+            med.appendTo(buffer);
+        if (!replaceFile(filename, buffer))
+        {
+            std::cerr << "Could not save " << filename << "\n";
+            return false;
         }
+        metrics::add(metrics::OP_SAVE, metrics::BYTES_WRITTEN, buffer.size());
+        metrics::add(metrics::OP_SAVE, metrics::FILES_CLOSED, 1);
+        return true;
     }
 
-    void saveToFile(const std::string &filename)
+    // Same layout as app.py's backup download (csv.writer defaults): header row,
+    // ISO expiry dates, fields with commas or quotes quoted, CRLF line ends.
+    bool saveBackupCsv(const std::string &filename)
     {
-        std::ofstream out(filename);
+        ensureLoaded();
+        std::string buffer;
+        MedicineSchema<Medicine>::BackupCsv::writeHeader(buffer);
+        buffer += "\r\n";
         for (const Medicine &med : inventory)
-            med.saveToFile(out);
+        {
+            MedicineSchema<Medicine>::BackupCsv::write(buffer, med);
+            buffer += "\r\n";
+        }
+        return replaceFile(filename, buffer);
+    }
+
+    // Reads a file written by saveBackupCsv() or app.py's backup download.
+    // Returns false, leaving the inventory unchanged, if it is missing or its
+    // header does not match.
+    bool loadBackupCsv(const std::string &filename)
+    {
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+        std::string header;
+        MedicineSchema<Medicine>::BackupCsv::writeHeader(header);
+        std::vector<Medicine> rows;
+        bool first = true, ok = false;
+        forEachLine(file.data(), file.size(), [&](const char *b, const char *e)
+        {
+            if (first)
+            {
+                first = false;
+                ok = header.compare(0, std::string::npos, b, (size_t)(e - b)) == 0;
+                return ok;
+            }
+            Medicine med;
+            MedicineSchema<Medicine>::BackupCsv::parse(b, e, med);
+            rows.push_back(std::move(med));
+            return true;
+        });
+        if (!ok)
+            return false;
+        lazy.reset();
+        inventory = std::move(rows);
+        rebuildIndex();
+        return true;
+    }
+
+    // Compact snapshot: "MED2" (version 2: 64-bit paise prices), u32 record count,
+    // then MedicineSchema::Binary records. Returns false if it cannot be written.
+    bool saveBinary(const std::string &filename)
+    {
+        ensureLoaded();
+        std::string buffer = "MED2";
+        MedicineSchema<Medicine>::Binary::put(buffer, (uint32_t)inventory.size(), 4);
+        for (const Medicine &med : inventory)
+            MedicineSchema<Medicine>::Binary::write(buffer, med);
+        return replaceFile(filename, buffer);
+    }
+
+    // Returns false, leaving the inventory empty, if the file is missing or malformed.
+    bool loadBinary(const std::string &filename)
+    {
+        lazy.reset();
+        inventory.clear();
+        MappedFile file;
+        bool ok = file.open(filename) && file.size() >= 8 && memcmp(file.data(), "MED2", 4) == 0;
+        if (ok)
+        {
+            const char *p = file.data() + 8;
+            const char *end = file.data() + file.size();
+            uint32_t count = MedicineSchema<Medicine>::Binary::get(file.data() + 4, 4);
+            inventory.reserve(std::min<size_t>(count, file.size() / 8));
+            for (uint32_t i = 0; ok && i < count; i++)
+            {
+                Medicine med;
+                ok = MedicineSchema<Medicine>::Binary::parse(p, end, med);
+                if (ok)
+                    inventory.push_back(std::move(med));
+            }
+        }
+        if (!ok)
+            inventory.clear();
+        rebuildIndex();
+        return ok;
+    }
+
+    // Books a supplier manifest in one pass. Rows use the inventory.txt layout
+    // (name,batch,expiry,qty,price; any sixth column is ignored) and are
+    // hash-joined against batchIndex: stocked batches gain qty in both quantity
+    // and originalQuantity and take the row's expiry, unknown batches are
+    // appended. The inventory is then saved once and the delivery logged as a
+    // single history entry. Returns false if the manifest cannot be read or the
+    // inventory cannot be saved; nothing is logged then.
+    bool receiveManifest(const std::string &filename, ReceiptSummary &summary)
+    {
+        ensureLoaded();
+        summary = ReceiptSummary();
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+        {
+            metrics::ScopedTimer timer(metrics::OP_RECEIVE);
+            forEachLine(file.data(), file.size(), [&](const char *b, const char *e)
+            {
+                summary.lines++;
+                uint32_t invalid = 0;
+                Medicine row = Medicine::parse(b, e, invalid);
+                int qty = row.getQuantity();
+                std::string expiry = row.getExpiryDate();
+                if (row.getBatchNumber().empty() || qty <= 0 || (!expiry.empty() && !Medicine::isValidDate(expiry)))
+                {
+                    summary.rejected++;
+                    return true;
+                }
+                auto slot = batchIndex.emplace(row.getBatchNumber(), inventory.size());
+                if (slot.second && (row.getName().empty() || (invalid & MedicineSchema<Medicine>::PRICE_BIT)))
+                {
+                    batchIndex.erase(slot.first);
+                    summary.rejected++;
+                    return true;
+                }
+                if (slot.second)
+                {
+                    inventory.push_back(Medicine(row.getName(), row.getBatchNumber(), expiry, qty, row.getPrice()));
+                    summary.added++;
+                }
+                else if (inventory[slot.first->second].receive(qty, expiry))
+                    summary.restocked++;
+                else
+                {
+                    summary.rejected++;
+                    return true;
+                }
+                summary.units += qty;
+                return true;
+            });
+            metrics::add(metrics::OP_RECEIVE, metrics::ROWS_SCANNED, summary.lines);
+        }
+        if (!saveToFile("inventory.txt"))
+            return false;
+        writeHistory("Received manifest " + filename + ": " + std::to_string(summary.lines) + " lines, " +
+                     std::to_string(summary.restocked) + " restocked, " + std::to_string(summary.added) +
+                     " new batches, " + std::to_string(summary.units) + " units, " +
+                     std::to_string(summary.rejected) + " rejected");
+        return true;
     }
 
     void addMedicine()
     {
         std::string name, batch, expiry;
         int quantity;
-        float price;
+        std::string priceText;
 
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         std::cout << "Enter medicine name: ";
@@ -167,12 +608,21 @@ public:
         std::cout << "Enter quantity: ";
         std::cin >> quantity;
         std::cout << "Enter price per unit: ";
-        std::cin >> price;
+        std::cin >> priceText;
+
+        money::Paise price;
+        if (!money::parse(priceText, price) || price < 0)
+        {
+            std::cout << "Invalid price.\n";
+            return;
+        }
 
+        ensureLoaded();
         inventory.push_back(Medicine(name, batch, expiry, quantity, price));
+        batchIndex.emplace(batch, inventory.size() - 1);
         saveToFile("inventory.txt");
         writeHistory("Added medicine: " + name + " (" + batch + "), qty=" +
-                     std::to_string(quantity) + ", price=" + std::to_string(price));
+                     std::to_string(quantity) + ", price=" + money::format(price));
         std::cout << "Medicine added successfully!\n";
     }
 
@@ -182,30 +632,50 @@ public:
         std::cout << "Enter batch number to update: ";
         std::cin >> batch;
 
-        for (Medicine &med : inventory)
+        ensureLoaded();
+        Medicine *med = findBatch(batch);
+        if (!med)
         {
-            if (med.getBatchNumber() == batch)
-            {
-                int newQty;
-                std::string newExp;
-                std::cout << "Enter new quantity: ";
-                std::cin >> newQty;
-                std::cout << "Enter new expiry date (YYYY-MM-DD): ";
-                std::cin >> newExp;
-                med.setQuantity(newQty);
-                med.setExpiryDate(newExp);
-                saveToFile("inventory.txt");
-                writeHistory("Updated medicine: " + med.getName() + " (" + med.getBatchNumber() +
-                             "), new qty=" + std::to_string(newQty));
-                std::cout << "Medicine updated successfully!\n";
-                return;
-            }
+            std::cout << "Medicine not found.\n";
+            return;
         }
-        std::cout << "Medicine not found.\n";
+
+        int newQty;
+        std::string newExp;
+        std::cout << "Enter new quantity: ";
+        std::cin >> newQty;
+        std::cout << "Enter new expiry date (YYYY-MM-DD): ";
+        std::cin >> newExp;
+        med->setQuantity(newQty);
+        med->setExpiryDate(newExp);
+        saveToFile("inventory.txt");
+        writeHistory("Updated medicine: " + med->getName() + " (" + med->getBatchNumber() +
+                     "), new qty=" + std::to_string(newQty));
+        std::cout << "Medicine updated successfully!\n";
+    }
+
+    void receiveDelivery()
+    {
+        std::string filename;
+        std::cout << "Enter manifest file (name,batch,expiry,qty,price per line): ";
+        std::cin >> filename;
+
+        ReceiptSummary summary;
+        if (!receiveManifest(filename, summary))
+        {
+            std::cout << "Could not receive " << filename << ".\n";
+            return;
+        }
+        std::cout << "Received " << summary.units << " units: " << summary.restocked << " restocked, "
+                  << summary.added << " new batches";
+        if (summary.rejected > 0)
+            std::cout << ", " << summary.rejected << " rows rejected";
+        std::cout << ".\n";
     }
 
     void removeExpired()
     {
+        ensureLoaded();
         auto it = inventory.begin();
         while (it != inventory.end())
         {
@@ -219,45 +689,49 @@ public:
                 ++it;
             }
         }
+        rebuildIndex();
         saveToFile("inventory.txt");
         std::cout << "Expired medicines removed.\n";
     }
 
-    void generateLowStockReport() const
+    void generateLowStockReport()
     {
+        ensureLoaded();
+        metrics::ScopedTimer timer(metrics::OP_REPORT_LOW_STOCK);
+        metrics::add(metrics::OP_REPORT_LOW_STOCK, metrics::ROWS_SCANNED, inventory.size());
         std::cout << "\n=== LOW STOCK REPORT ===\n";
         for (const Medicine &med : inventory)
             if (med.getQuantity() < LOW_STOCK_THRESHOLD)
                 med.display();
     }
 
-    void generateExpiredReport() const
+    void generateExpiredReport()
     {
+        ensureLoaded();
+        metrics::ScopedTimer timer(metrics::OP_REPORT_EXPIRED);
+        metrics::add(metrics::OP_REPORT_EXPIRED, metrics::ROWS_SCANNED, inventory.size());
         std::cout << "\n=== EXPIRED MEDICINES REPORT ===\n";
         for (const Medicine &med : inventory)
             if (med.isExpired())
                 med.display();
     }
 
-    void displayInventory() const
+    void displayInventory()
     {
+        ensureLoaded();
+        metrics::ScopedTimer timer(metrics::OP_REPORT_INVENTORY);
+        metrics::add(metrics::OP_REPORT_INVENTORY, metrics::ROWS_SCANNED, inventory.size());
         std::cout << "\n=== INVENTORY LIST ===\n";
-        std::cout << std::left << std::setw(15) << "Name"
-                  << std::setw(12) << "Batch"
-                  << std::setw(15) << "Expiry"
-                  << std::setw(10) << "QtyLeft"
-                  << std::setw(12) << "Price/Unit"
-                  << std::setw(15) << "OriginalQty" << "\n";
-        std::cout << "--------------------------------------------------------------------------\n";
+        MedicineSchema<Medicine>::Table::header(std::cout);
         for (const Medicine &med : inventory)
             med.display();
     }
 
     void buyMedicines()
     {
-        std::vector<std::tuple<std::string, int, float>> billItems;
+        billing::Bill bill;
+        std::vector<std::string> names;
         char choice;
-        float total = 0.0f;
 
         do
         {
@@ -266,52 +740,46 @@ public:
             std::cout << "Enter batch number to purchase: ";
             std::cin >> batch;
 
-            bool found = false;
-            for (Medicine &med : inventory)
+            Medicine *med = findBatch(batch);
+            if (med)
             {
-                if (med.getBatchNumber() == batch)
+                std::cout << "Enter quantity to buy: ";
+                std::cin >> qty;
+                if (sellBatch(*med, qty, bill))
+                {
+                    names.push_back(med->getName());
+                    std::cout << "Added to bill: " << med->getName() << " x" << qty << "\n";
+                }
+                else if (!billing::Bill::fits(med->getPrice(), qty))
+                    std::cout << "Cannot bill this quantity at this price.\n";
+                else
                 {
-                    std::cout << "Enter quantity to buy: ";
-                    std::cin >> qty;
-                    if (med.sell(qty))
-                    {
-                        float cost = qty * med.getPrice();
-                        total += cost;
-                        billItems.push_back({med.getName(), qty, cost});
-                        writeHistory("Bought " + std::to_string(qty) + " of " + med.getName() +
-                                     " (" + med.getBatchNumber() + "), total=" + std::to_string(cost));
-                        std::cout << "Added to bill: " << med.getName() << " x" << qty << "\n";
-                    }
-                    else
-                    {
-                        std::cout << "Not enough stock available.\n";
-                    }
-                    found = true;
-                    break;
+                    std::cout << "Not enough stock available.\n";
                 }
             }
-            if (!found)
+            else
                 std::cout << "Medicine not found.\n";
 
             std::cout << "Do you want to buy another medicine? (y/n): ";
             std::cin >> choice;
         } while (choice == 'y' || choice == 'Y');
 
-        if (!billItems.empty())
+        if (bill.size() > 0)
         {
+            billing::Totals totals = bill.total();
             std::cout << "\n===== FINAL BILL =====\n";
             std::cout << std::left << std::setw(15) << "Medicine"
                       << std::setw(8) << "Qty"
                       << std::setw(10) << "Cost" << "\n";
             std::cout << "----------------------------------\n";
-            for (auto &item : billItems)
+            for (size_t i = 0; i < bill.size(); i++)
             {
-                std::cout << std::setw(15) << std::get<0>(item)
-                          << std::setw(8) << std::get<1>(item)
-                          << std::setw(10) << std::get<2>(item) << "\n";
+                std::cout << std::setw(15) << names[i]
+                          << std::setw(8) << bill.qty[i]
+                          << std::setw(10) << money::format(bill.net[i]) << "\n";
             }
             std::cout << "----------------------------------\n";
-            std::cout << "TOTAL: " << total << "\n";
+            std::cout << "TOTAL: " << money::format(totals.net) << "\n";
             std::cout << "=======================\n";
             saveToFile("inventory.txt");
         }
@@ -321,18 +789,50 @@ public:
         }
     }
 
+    // Archived and live history entries matching q, oldest first.
+    std::vector<std::string> queryHistory(const HistoryQuery &q)
+    {
+        metrics::ScopedTimer timer(metrics::OP_SCAN_HISTORY);
+        uint64_t scanned = 0;
+        std::vector<std::string> lines = history.scan(q, 0, &scanned);
+        metrics::add(metrics::OP_SCAN_HISTORY, metrics::ROWS_SCANNED, scanned);
+        return lines;
+    }
+
     void showHistory()
     {
-        std::ifstream in("history.txt");
-        if (!in)
+        std::vector<std::string> lines = queryHistory(HistoryQuery());
+        if (lines.empty())
         {
             std::cout << "No history found.\n";
             return;
         }
 
         std::cout << "\n=== ACTION HISTORY ===\n";
-        std::string line;
-        while (getline(in, line))
+        for (const std::string &line : lines)
+            std::cout << line << "\n";
+    }
+
+    void searchHistory()
+    {
+        HistoryQuery q;
+        std::string batch;
+        std::cout << "Enter batch number (* for all): ";
+        std::cin >> batch;
+        std::cout << "From date (YYYY-MM-DD, * for start): ";
+        std::cin >> q.from;
+        std::cout << "To date (YYYY-MM-DD, * for today): ";
+        std::cin >> q.to;
+        if (batch != "*")
+            q.needles.push_back("(" + batch + ")");
+        if (q.from == "*")
+            q.from.clear();
+        if (q.to == "*")
+            q.to.clear();
+
+        std::vector<std::string> lines = queryHistory(q);
+        std::cout << "\n=== HISTORY SEARCH (" << lines.size() << " entries) ===\n";
+        for (const std::string &line : lines)
             std::cout << line << "\n";
     }
 };
@@ -340,10 +840,15 @@ public:
 // ===============================
 // Main Menu
 // ===============================
-int main()
+// bench.cpp includes this file with MEDINV_NO_MAIN defined to reuse the classes.
+#ifndef MEDINV_NO_MAIN
+int main(int argc, char **argv)
 {
     InventoryManager manager;
-    manager.loadFromFile("inventory.txt");
+    if (argc > 1 && std::string(argv[1]) == "--lazy")
+        manager.openLazy("inventory.txt");
+    else
+        manager.loadFromFile("inventory.txt");
 
     int choice;
     do
@@ -357,7 +862,10 @@ int main()
         std::cout << "6. Show Inventory\n";
         std::cout << "7. Buy Medicines (Generate Bill)\n";
         std::cout << "8. Show History Log\n";
-        std::cout << "9. Exit\n";
+        std::cout << "9. Search History\n";
+        std::cout << "10. Dump Metrics\n";
+        std::cout << "11. Receive Supplier Manifest\n";
+        std::cout << "12. Exit\n";
         std::cout << "Enter your choice: ";
         std::cin >> choice;
 
@@ -395,13 +903,26 @@ int main()
             manager.showHistory();
             break;
         case 9:
+            manager.searchHistory();
+            break;
+        case 10:
+            if (metrics::dumpToFile("metrics.prom"))
+                std::cout << "Metrics written to metrics.prom\n";
+            else
+                std::cout << "Could not write metrics.prom\n";
+            break;
+        case 11:
+            manager.receiveDelivery();
+            break;
+        case 12:
             std::cout << "Exiting...\n";
             break;
         default:
             std::cout << "Invalid choice.\n";
             break;
         }
-    } while (choice != 9);
+    } while (choice != 12);
 
     return 0;
 }
+#endif